@@ -105,9 +105,9 @@ extern void LogMsg(LogLevel level, const char* msg, ...);
 #if defined(__clang__) || defined(__GNUC__)
 #define _NEVER_INLINE_ __attribute__((__noinline__)) inline
 #elif defined(_MSC_VER)
-#define _NEVER_INLINE __declspec(noinline)
+#define _NEVER_INLINE_ __declspec(noinline) inline
 #else
-#define _NEVER_INLINE_ 
+#define _NEVER_INLINE_ inline
 #endif
 #endif
 
@@ -230,6 +230,7 @@ constant_var size_t SCAL_PAGE_SIZE = Kilobytes(4);
 
 #define SMemCopy(dst, src, size) memcpy((dst), (src), (size))
 #define SMemMove(dst, src, size) memmove((dst), (src), (size))
+#define SMemCmp(a, b, size) memcmp((a), (b), (size))
 #define SMemSet(dst, val_u8, size) zpl_memset((dst), (val_u8), (size))
 #define SMemZero(dst, size) (SMemSet((dst), 0, (size)))
 
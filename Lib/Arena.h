@@ -172,7 +172,7 @@ inline void ArenaGrow(Arena* a, size_t sizeNeeded)
 	SAssert(a->Memory);
 	SAssert(a->ReservedSize > 0);
 	SAssert(sizeNeeded > 0);
-	SAssert(AlignSize(sizeNeeded, a->Alignment) < a->ReservedSize);
+	SAssert(AlignSize(sizeNeeded, a->Alignment) <= a->ReservedSize);
 
 	size_t newSize = AlignSize(sizeNeeded, a->Alignment);
 	// Note: Docs say you are allowed to commit to already commited pages
@@ -180,7 +180,9 @@ inline void ArenaGrow(Arena* a, size_t sizeNeeded)
 	if (!resultPtr)
 	{
 		SCAL_ERROR("Arena failed to grow.");
+		return;
 	}
+	a->Size = newSize;
 }
 
 inline void ArenaShrink(Arena* a)
@@ -0,0 +1,699 @@
+#pragma once
+
+#include "Core.h"
+#include "Jobs.h"
+#include "Futex.h"
+
+// Asynchronous file reads and writes that finish a JobHandle, or queue a continuation job, when
+// the I/O is done, so job workers never block on disk. Linux uses one io_uring with a reaper
+// thread. Elsewhere, when io_uring is unavailable or with SCAL_ASYNCIO_URING 0, a few I/O
+// threads do blocking positioned reads and writes instead.
+#ifndef SCAL_ASYNCIO_URING
+#ifdef PLATFORM_LINUX
+#define SCAL_ASYNCIO_URING 1
+#else
+#define SCAL_ASYNCIO_URING 0
+#endif
+#endif
+
+#ifdef _WIN32
+#include <Windows.h>
+typedef HANDLE AsyncIOFile;
+#define ASYNCIO_INVALID_FILE INVALID_HANDLE_VALUE
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+typedef int AsyncIOFile;
+#define ASYNCIO_INVALID_FILE -1
+#endif
+
+#if SCAL_ASYNCIO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+// Submission queue entries of the ring, the completion queue is twice as large
+#define ASYNCIO_DEFAULT_QUEUE_DEPTH 256
+#define ASYNCIO_DEFAULT_THREAD_COUNT 2
+#define ASYNCIO_MAX_THREAD_COUNT 16
+
+enum AsyncIOOp
+{
+	ASYNCIO_OP_READ,
+	ASYNCIO_OP_WRITE,
+};
+
+struct AsyncIORequest
+{
+	AsyncIOFile File;
+	void* Buffer;
+	u64 Offset;
+	u32 Size;
+	u32 Done;					// bytes transferred so far, short transfers are continued
+	i32 Result;					// bytes transferred, or a negative error code. Valid once Handle is done.
+	AsyncIOOp Op;
+	JobHandle* Handle;			// busy until the I/O, and the continuation if any, finished
+	JobWorkFunc Continuation;	// optional, queued with the request as StackMemory
+	JobPriority Priority;		// of the continuation
+	AsyncIORequest* Next;
+};
+
+// Start the ring or the I/O threads. Without it requests run on the submitting thread.
+bool AsyncIOInitialize(u32 queueDepth = ASYNCIO_DEFAULT_QUEUE_DEPTH, u32 threadCount = ASYNCIO_DEFAULT_THREAD_COUNT);
+
+// Waits for the I/O in flight, then stops the reaper or I/O threads
+void AsyncIOShutdown();
+
+AsyncIOFile AsyncIOOpen(const char* path, bool forWrite);
+void AsyncIOClose(AsyncIOFile file);
+
+// Read size bytes at offset into a buffer pushed on arena. The request is pushed on arena too,
+// so arena must outlive the read, and only the calling thread may use it meanwhile.
+AsyncIORequest* AsyncIORead(Arena* arena, AsyncIOFile file, u64 offset, u32 size, JobHandle* handle,
+	JobWorkFunc continuation = nullptr, JobPriority priority = JOB_PRIORITY_NORMAL);
+
+// Write size bytes of data at offset. data must stay valid until the handle is done, the
+// request is pushed on arena.
+AsyncIORequest* AsyncIOWrite(Arena* arena, AsyncIOFile file, u64 offset, const void* data, u32 size, JobHandle* handle,
+	JobWorkFunc continuation = nullptr, JobPriority priority = JOB_PRIORITY_NORMAL);
+
+// Submit a request filled in by the caller, it must stay valid until its handle is done
+void AsyncIOSubmit(AsyncIORequest* request);
+
+// Submit many requests with one io_uring_enter, same rules as AsyncIOSubmit
+void AsyncIOSubmitMany(AsyncIORequest** requests, u32 count);
+
+struct AsyncIOInternalState
+{
+	zpl_atomic32 IsAlive;
+	zpl_atomic32 InFlight;		// submitted and not completed yet
+	bool UseUring;
+
+#if SCAL_ASYNCIO_URING
+	int RingFd;
+	void* SqRing;
+	size_t SqRingSize;
+	void* CqRing;
+	size_t CqRingSize;
+	io_uring_sqe* Sqes;
+	size_t SqesSize;
+	u32* SqHead;
+	u32* SqTail;
+	u32* SqMask;
+	u32* SqArray;
+	u32 SqEntries;
+	u32* CqHead;
+	u32* CqTail;
+	u32* CqMask;
+	io_uring_cqe* Cqes;
+	u32 CqEntries;
+
+	zpl_mutex SubmitLock;		// guards the submission queue, RingInFlight and the pending list
+	u32 RingInFlight;			// capped at CqEntries so completions never overflow
+	AsyncIORequest* PendingFirst;	// waiting for room in the ring
+	AsyncIORequest* PendingLast;
+	zpl_thread Reaper;
+#endif
+
+	zpl_mutex QueueLock;		// guards the I/O thread queue
+	AsyncIORequest* QueueFirst;
+	AsyncIORequest* QueueLast;
+	zpl_atomic32 QueueEpoch;	// futex idle I/O threads sleep on
+	zpl_thread Threads[ASYNCIO_MAX_THREAD_COUNT];
+	u32 ThreadCount;
+};
+
+internal AsyncIOInternalState AsyncIOState;
+
+// Blocking transfer of whatever is left of the request, returns the result
+internal i32
+AsyncIOTransferBlocking(AsyncIORequest* request)
+{
+	while (request->Done < request->Size)
+	{
+		u8* buffer = (u8*)request->Buffer + request->Done;
+		u32 size = request->Size - request->Done;
+		u64 offset = request->Offset + request->Done;
+#ifdef _WIN32
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)offset;
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		DWORD transferred = 0;
+		BOOL ok = (request->Op == ASYNCIO_OP_READ)
+			? ReadFile(request->File, buffer, size, &transferred, &overlapped)
+			: WriteFile(request->File, buffer, size, &transferred, &overlapped);
+		if (!ok)
+		{
+			DWORD error = GetLastError();
+			if (error == ERROR_HANDLE_EOF)
+				break;
+			return -(i32)error;
+		}
+#else
+		ssize_t transferred = (request->Op == ASYNCIO_OP_READ)
+			? pread(request->File, buffer, size, (off_t)offset)
+			: pwrite(request->File, buffer, size, (off_t)offset);
+		if (transferred < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+#endif
+		if (transferred == 0)
+			break; // end of file
+		request->Done += (u32)transferred;
+	}
+	return (i32)request->Done;
+}
+
+internal void
+AsyncIOComplete(AsyncIORequest* request, i32 result)
+{
+	request->Result = result;
+
+	// The continuation joins the handle before the I/O leaves it, so it never looks done early
+	if (request->Continuation)
+		JobsExecute(request->Handle, request->Continuation, request, request->Priority);
+
+	zpl_atomic32_fetch_add(&AsyncIOState.InFlight, -1);
+	JobHandleRelease(request->Handle, 1);
+}
+
+#if SCAL_ASYNCIO_URING
+
+// The ring's head and tail are shared with the kernel
+_FORCE_INLINE_ u32
+AsyncIOLoadAcquire(const u32* value)
+{
+	u32 result = *(const volatile u32*)value;
+	zpl_mfence();
+	return result;
+}
+
+_FORCE_INLINE_ void
+AsyncIOStoreRelease(u32* value, u32 newValue)
+{
+	zpl_mfence();
+	*(volatile u32*)value = newValue;
+}
+
+internal int
+AsyncIOUringEnter(u32 toSubmit, u32 minComplete, u32 flags)
+{
+	return (int)syscall(__NR_io_uring_enter, AsyncIOState.RingFd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+// Must hold SubmitLock. False when the ring is full, request is then left to the caller.
+// The entry is only queued, AsyncIOUringFlush hands it to the kernel.
+internal bool
+AsyncIOUringPush(AsyncIORequest* request)
+{
+	if (AsyncIOState.RingInFlight >= AsyncIOState.CqEntries)
+		return false;
+
+	u32 tail = *AsyncIOState.SqTail;
+	if (tail - AsyncIOLoadAcquire(AsyncIOState.SqHead) >= AsyncIOState.SqEntries)
+		return false;
+
+	u32 index = tail & *AsyncIOState.SqMask;
+	io_uring_sqe* sqe = &AsyncIOState.Sqes[index];
+	SMemZero(sqe, sizeof(io_uring_sqe));
+	if (request)
+	{
+		sqe->opcode = (request->Op == ASYNCIO_OP_READ) ? IORING_OP_READ : IORING_OP_WRITE;
+		sqe->fd = request->File;
+		sqe->addr = (u64)((u8*)request->Buffer + request->Done);
+		sqe->len = request->Size - request->Done;
+		sqe->off = request->Offset + request->Done;
+	}
+	else
+	{
+		sqe->opcode = IORING_OP_NOP; // wakes the reaper on shutdown
+	}
+	sqe->user_data = (u64)request;
+
+	AsyncIOState.SqArray[index] = index;
+	AsyncIOStoreRelease(AsyncIOState.SqTail, tail + 1);
+	++AsyncIOState.RingInFlight;
+	return true;
+}
+
+// Pushed entries the kernel has not taken yet
+_FORCE_INLINE_ u32
+AsyncIOUringUnsubmitted()
+{
+	return *AsyncIOState.SqTail - AsyncIOLoadAcquire(AsyncIOState.SqHead);
+}
+
+// Must hold SubmitLock. One io_uring_enter for every entry the kernel has not taken yet, so
+// entries left over by an earlier flush are retried too. Entries are only left over while the
+// kernel holds others, the reaper wakes on their completion and flushes again. When the kernel
+// refuses them for good they are taken back out of the ring and their requests added to
+// failed, with Result set to the error. Complete those after dropping the lock. False if that
+// happened.
+internal bool
+AsyncIOUringFlush(AsyncIORequest** failed)
+{
+	for (;;)
+	{
+		u32 toSubmit = AsyncIOUringUnsubmitted();
+		if (toSubmit == 0)
+			return true;
+
+		int submitted = AsyncIOUringEnter(toSubmit, 0, 0);
+		if (submitted > 0)
+			continue;
+		if (submitted == 0 || errno == EAGAIN || errno == EBUSY)
+		{
+			// Out of kernel resources for now
+			if (AsyncIOState.RingInFlight > toSubmit)
+				return true;
+			zpl_yield_thread();
+			continue;
+		}
+		if (errno == EINTR)
+			continue;
+		break;
+	}
+
+	int error = errno;
+	LogErr("[ AsyncIO ] io_uring_enter submit failed, errno %d", error);
+
+	// Only flushes submit and they hold SubmitLock, so the kernel cannot take these meanwhile
+	u32 head = AsyncIOLoadAcquire(AsyncIOState.SqHead);
+	u32 tail = *AsyncIOState.SqTail;
+	for (u32 position = head; position != tail; ++position)
+	{
+		io_uring_sqe* sqe = &AsyncIOState.Sqes[AsyncIOState.SqArray[position & *AsyncIOState.SqMask]];
+		AsyncIORequest* request = (AsyncIORequest*)sqe->user_data;
+		if (request)
+		{
+			request->Result = -error;
+			SLStackPush(*failed, request, Next);
+		}
+	}
+	AsyncIOStoreRelease(AsyncIOState.SqTail, head);
+	AsyncIOState.RingInFlight -= tail - head;
+	return false;
+}
+
+// Outside SubmitLock, continuations may submit again
+internal void
+AsyncIOUringCompleteFailed(AsyncIORequest* failed)
+{
+	while (failed)
+	{
+		AsyncIORequest* request = failed;
+		SLStackPop(failed, Next);
+		AsyncIOComplete(request, request->Result);
+	}
+}
+
+internal void
+AsyncIOUringSubmit(AsyncIORequest** requests, u32 count)
+{
+	AsyncIORequest* failed = nullptr;
+	zpl_mutex_lock(&AsyncIOState.SubmitLock);
+	for (u32 requestIdx = 0; requestIdx < count; ++requestIdx)
+	{
+		AsyncIORequest* request = requests[requestIdx];
+		if (AsyncIOState.PendingFirst || !AsyncIOUringPush(request))
+		{
+			request->Next = nullptr;
+			SLQueuePush(AsyncIOState.PendingFirst, AsyncIOState.PendingLast, request, Next);
+		}
+	}
+	AsyncIOUringFlush(&failed);
+	zpl_mutex_unlock(&AsyncIOState.SubmitLock);
+	AsyncIOUringCompleteFailed(failed);
+}
+
+// Waits for completions, continues short transfers and moves pending requests into the ring
+internal zpl_isize
+AsyncIOReaperProc(zpl_thread*)
+{
+	bool isRunning = true;
+	while (isRunning)
+	{
+		int entered = AsyncIOUringEnter(0, 1, IORING_ENTER_GETEVENTS);
+		if (entered < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+		{
+			LogErr("[ AsyncIO ] io_uring_enter wait failed, errno %d", errno);
+			zpl_yield_thread();
+		}
+
+		u32 head = *AsyncIOState.CqHead;
+		u32 tail = AsyncIOLoadAcquire(AsyncIOState.CqTail);
+		u32 reaped = 0;
+		AsyncIORequest* continued = nullptr;
+		while (head != tail)
+		{
+			io_uring_cqe* cqe = &AsyncIOState.Cqes[head & *AsyncIOState.CqMask];
+			AsyncIORequest* request = (AsyncIORequest*)cqe->user_data;
+			i32 res = cqe->res;
+			++head;
+			++reaped;
+
+			if (!request)
+			{
+				isRunning = false;
+				continue;
+			}
+
+			if (res > 0 && request->Done + (u32)res < request->Size)
+			{
+				request->Done += (u32)res;
+				SLStackPush(continued, request, Next);
+			}
+			else
+			{
+				AsyncIOComplete(request, (res < 0) ? res : (i32)(request->Done + (u32)res));
+			}
+		}
+		AsyncIOStoreRelease(AsyncIOState.CqHead, head);
+
+		// Also retries entries an earlier flush left in the ring
+		AsyncIORequest* failed = nullptr;
+		zpl_mutex_lock(&AsyncIOState.SubmitLock);
+		AsyncIOState.RingInFlight -= reaped;
+		while (continued)
+		{
+			AsyncIORequest* request = continued;
+			SLStackPop(continued, Next);
+			request->Next = nullptr;
+			SLQueuePush(AsyncIOState.PendingFirst, AsyncIOState.PendingLast, request, Next);
+		}
+		while (AsyncIOState.PendingFirst && AsyncIOUringPush(AsyncIOState.PendingFirst))
+		{
+			SLQueuePop(AsyncIOState.PendingFirst, AsyncIOState.PendingLast);
+		}
+		AsyncIOUringFlush(&failed);
+		zpl_mutex_unlock(&AsyncIOState.SubmitLock);
+		AsyncIOUringCompleteFailed(failed);
+	}
+	return 0;
+}
+
+internal bool
+AsyncIOUringInitialize(u32 queueDepth)
+{
+	io_uring_params params = {};
+	int fd = (int)syscall(__NR_io_uring_setup, queueDepth, &params);
+	if (fd < 0)
+	{
+		LogInfo("[ AsyncIO ] io_uring unavailable, errno %d. Using I/O threads.", errno);
+		return false;
+	}
+
+	size_t sqRingSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+	size_t cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool isSingleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (isSingleMmap)
+	{
+		sqRingSize = Max(sqRingSize, cqRingSize);
+		cqRingSize = sqRingSize;
+	}
+
+	void* sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	void* cqRing = isSingleMmap ? sqRing
+		: mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+	size_t sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	void* sqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED)
+	{
+		LogErr("[ AsyncIO ] io_uring mmap failed, errno %d. Using I/O threads.", errno);
+		if (sqes != MAP_FAILED)
+			munmap(sqes, sqesSize);
+		if (!isSingleMmap && cqRing != MAP_FAILED)
+			munmap(cqRing, cqRingSize);
+		if (sqRing != MAP_FAILED)
+			munmap(sqRing, sqRingSize);
+		close(fd);
+		return false;
+	}
+
+	AsyncIOState.RingFd = fd;
+	AsyncIOState.SqRing = sqRing;
+	AsyncIOState.SqRingSize = sqRingSize;
+	AsyncIOState.CqRing = cqRing;
+	AsyncIOState.CqRingSize = cqRingSize;
+	AsyncIOState.Sqes = (io_uring_sqe*)sqes;
+	AsyncIOState.SqesSize = sqesSize;
+
+	u8* sq = (u8*)sqRing;
+	AsyncIOState.SqHead = (u32*)(sq + params.sq_off.head);
+	AsyncIOState.SqTail = (u32*)(sq + params.sq_off.tail);
+	AsyncIOState.SqMask = (u32*)(sq + params.sq_off.ring_mask);
+	AsyncIOState.SqArray = (u32*)(sq + params.sq_off.array);
+	AsyncIOState.SqEntries = params.sq_entries;
+
+	u8* cq = (u8*)cqRing;
+	AsyncIOState.CqHead = (u32*)(cq + params.cq_off.head);
+	AsyncIOState.CqTail = (u32*)(cq + params.cq_off.tail);
+	AsyncIOState.CqMask = (u32*)(cq + params.cq_off.ring_mask);
+	AsyncIOState.Cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+	AsyncIOState.CqEntries = params.cq_entries;
+
+	zpl_mutex_init(&AsyncIOState.SubmitLock);
+	AsyncIOState.RingInFlight = 0;
+	AsyncIOState.PendingFirst = nullptr;
+	AsyncIOState.PendingLast = nullptr;
+
+	zpl_thread_init(&AsyncIOState.Reaper);
+	zpl_thread_start(&AsyncIOState.Reaper, AsyncIOReaperProc, nullptr);
+
+	LogInfo("[ AsyncIO ] io_uring with %u entries.", params.sq_entries);
+	return true;
+}
+
+internal void
+AsyncIOUringShutdown()
+{
+	// Nothing is in flight, but the reaper may not have given back the last completions yet.
+	// Pushed again if the kernel refused it, the reaper only stops on this entry.
+	for (;;)
+	{
+		AsyncIORequest* failed = nullptr;
+		zpl_mutex_lock(&AsyncIOState.SubmitLock);
+		bool isQueued = AsyncIOUringPush(nullptr) && AsyncIOUringFlush(&failed);
+		zpl_mutex_unlock(&AsyncIOState.SubmitLock);
+		AsyncIOUringCompleteFailed(failed);
+		if (isQueued)
+			break;
+		zpl_yield_thread();
+	}
+
+	zpl_thread_join(&AsyncIOState.Reaper);
+	zpl_thread_destroy(&AsyncIOState.Reaper);
+
+	munmap(AsyncIOState.Sqes, AsyncIOState.SqesSize);
+	if (AsyncIOState.CqRing != AsyncIOState.SqRing)
+		munmap(AsyncIOState.CqRing, AsyncIOState.CqRingSize);
+	munmap(AsyncIOState.SqRing, AsyncIOState.SqRingSize);
+	close(AsyncIOState.RingFd);
+	zpl_mutex_destroy(&AsyncIOState.SubmitLock);
+}
+
+#endif // SCAL_ASYNCIO_URING
+
+internal zpl_isize
+AsyncIOThreadProc(zpl_thread*)
+{
+	for (;;)
+	{
+		i32 epoch = zpl_atomic32_load(&AsyncIOState.QueueEpoch);
+
+		zpl_mutex_lock(&AsyncIOState.QueueLock);
+		AsyncIORequest* request = AsyncIOState.QueueFirst;
+		if (request)
+			SLQueuePop(AsyncIOState.QueueFirst, AsyncIOState.QueueLast);
+		zpl_mutex_unlock(&AsyncIOState.QueueLock);
+
+		if (request)
+		{
+			AsyncIOComplete(request, AsyncIOTransferBlocking(request));
+			continue;
+		}
+
+		if (!zpl_atomic32_load(&AsyncIOState.IsAlive))
+			break;
+
+		FutexWait(&AsyncIOState.QueueEpoch, epoch);
+	}
+	return 0;
+}
+
+bool AsyncIOInitialize(u32 queueDepth, u32 threadCount)
+{
+	if (zpl_atomic32_load(&AsyncIOState.IsAlive))
+	{
+		SCAL_ERROR("AsyncIO already initialized");
+		return false;
+	}
+
+	zpl_atomic32_store(&AsyncIOState.InFlight, 0);
+	zpl_mutex_init(&AsyncIOState.QueueLock);
+	AsyncIOState.QueueFirst = nullptr;
+	AsyncIOState.QueueLast = nullptr;
+	AsyncIOState.ThreadCount = 0;
+
+	AsyncIOState.UseUring = false;
+#if SCAL_ASYNCIO_URING
+	AsyncIOState.UseUring = AsyncIOUringInitialize(Max(1u, queueDepth));
+#else
+	(void)queueDepth; // only sizes the ring
+#endif
+
+	zpl_atomic32_store(&AsyncIOState.IsAlive, 1);
+
+	if (!AsyncIOState.UseUring)
+	{
+		AsyncIOState.ThreadCount = ClampValue(threadCount, 1u, (u32)ASYNCIO_MAX_THREAD_COUNT);
+		for (u32 threadIdx = 0; threadIdx < AsyncIOState.ThreadCount; ++threadIdx)
+		{
+			zpl_thread_init(&AsyncIOState.Threads[threadIdx]);
+			zpl_thread_start(&AsyncIOState.Threads[threadIdx], AsyncIOThreadProc, nullptr);
+		}
+		LogInfo("[ AsyncIO ] %u I/O threads.", AsyncIOState.ThreadCount);
+	}
+	return true;
+}
+
+void AsyncIOShutdown()
+{
+	if (!zpl_atomic32_load(&AsyncIOState.IsAlive))
+		return;
+
+	while (zpl_atomic32_load(&AsyncIOState.InFlight) > 0)
+		zpl_yield_thread();
+
+	zpl_atomic32_store(&AsyncIOState.IsAlive, 0);
+
+#if SCAL_ASYNCIO_URING
+	if (AsyncIOState.UseUring)
+		AsyncIOUringShutdown();
+#endif
+
+	zpl_atomic32_fetch_add(&AsyncIOState.QueueEpoch, 1);
+	FutexWakeAll(&AsyncIOState.QueueEpoch);
+	for (u32 threadIdx = 0; threadIdx < AsyncIOState.ThreadCount; ++threadIdx)
+	{
+		zpl_thread_join(&AsyncIOState.Threads[threadIdx]);
+		zpl_thread_destroy(&AsyncIOState.Threads[threadIdx]);
+	}
+	AsyncIOState.ThreadCount = 0;
+	zpl_mutex_destroy(&AsyncIOState.QueueLock);
+}
+
+AsyncIOFile AsyncIOOpen(const char* path, bool forWrite)
+{
+	SAssert(path);
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, forWrite ? GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, nullptr,
+		forWrite ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		LogErr("[ AsyncIO ] Could not open %s, error %lu", path, GetLastError());
+#else
+	int file = forWrite ? open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644) : open(path, O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+		LogErr("[ AsyncIO ] Could not open %s, errno %d", path, errno);
+#endif
+	return file;
+}
+
+void AsyncIOClose(AsyncIOFile file)
+{
+	if (file == ASYNCIO_INVALID_FILE)
+		return;
+#ifdef _WIN32
+	CloseHandle(file);
+#else
+	close(file);
+#endif
+}
+
+void AsyncIOSubmit(AsyncIORequest* request)
+{
+	AsyncIOSubmitMany(&request, 1);
+}
+
+void AsyncIOSubmitMany(AsyncIORequest** requests, u32 count)
+{
+	SAssert(requests);
+	for (u32 requestIdx = 0; requestIdx < count; ++requestIdx)
+	{
+		AsyncIORequest* request = requests[requestIdx];
+		SAssert(request);
+		SAssert(request->Handle);
+		SAssert(request->Buffer);
+		SAssert(request->Size > 0);
+
+		request->Done = 0;
+		request->Result = 0;
+		request->Next = nullptr;
+
+		// Context state is updated:
+		zpl_atomic32_fetch_add(&request->Handle->Counter, 1);
+		zpl_atomic32_fetch_add(&AsyncIOState.InFlight, 1);
+	}
+
+	if (!zpl_atomic32_load(&AsyncIOState.IsAlive))
+	{
+		for (u32 requestIdx = 0; requestIdx < count; ++requestIdx)
+			AsyncIOComplete(requests[requestIdx], AsyncIOTransferBlocking(requests[requestIdx]));
+		return;
+	}
+
+#if SCAL_ASYNCIO_URING
+	if (AsyncIOState.UseUring)
+	{
+		AsyncIOUringSubmit(requests, count);
+		return;
+	}
+#endif
+
+	zpl_mutex_lock(&AsyncIOState.QueueLock);
+	for (u32 requestIdx = 0; requestIdx < count; ++requestIdx)
+		SLQueuePush(AsyncIOState.QueueFirst, AsyncIOState.QueueLast, requests[requestIdx], Next);
+	zpl_mutex_unlock(&AsyncIOState.QueueLock);
+
+	zpl_atomic32_fetch_add(&AsyncIOState.QueueEpoch, 1);
+	FutexWake(&AsyncIOState.QueueEpoch, (i32)count);
+}
+
+AsyncIORequest* AsyncIORead(Arena* arena, AsyncIOFile file, u64 offset, u32 size, JobHandle* handle,
+	JobWorkFunc continuation, JobPriority priority)
+{
+	SAssert(arena);
+	AsyncIORequest* request = ArenaPushStructZero(arena, AsyncIORequest);
+	request->File = file;
+	request->Buffer = ArenaPush(arena, size);
+	request->Offset = offset;
+	request->Size = size;
+	request->Op = ASYNCIO_OP_READ;
+	request->Handle = handle;
+	request->Continuation = continuation;
+	request->Priority = priority;
+	AsyncIOSubmit(request);
+	return request;
+}
+
+AsyncIORequest* AsyncIOWrite(Arena* arena, AsyncIOFile file, u64 offset, const void* data, u32 size, JobHandle* handle,
+	JobWorkFunc continuation, JobPriority priority)
+{
+	SAssert(arena);
+	AsyncIORequest* request = ArenaPushStructZero(arena, AsyncIORequest);
+	request->File = file;
+	request->Buffer = (void*)data;
+	request->Offset = offset;
+	request->Size = size;
+	request->Op = ASYNCIO_OP_WRITE;
+	request->Handle = handle;
+	request->Continuation = continuation;
+	request->Priority = priority;
+	AsyncIOSubmit(request);
+	return request;
+}
@@ -19,10 +19,6 @@ struct BHeap
     int Count;
     int Capacity;
 
-    static void HeapifyMin(BHeap* bh, int index);
-
-    static void HeapifyMax(BHeap* bh, int index);
-
     void Init(Arena* arena, int capacity, BHeapCompareFunc compareFunc)
     {
         SAssert(arena);
@@ -162,7 +158,7 @@ struct BHeap
         return Count == 0;
     }
 
-        static void HeapifyMin(BHeap* bh, int index)
+    static void HeapifyMin(BHeap* bh, int index)
     {
         int _2i = 2 * index;
         int _min = index;
@@ -174,9 +170,9 @@ struct BHeap
             int left = _2i + 1;
             int right = _2i + 2;
 
-            if (bh->Items[left].Key < bh->Items[_min].Key)
+            if (bh->CompareFunc(bh->Items[left].Key, bh->Items[_min].Key) < 0)
                 _min = left;
-            if (right < count && bh->Items[right].Key < bh->Items[_min].Key)
+            if (right < count && bh->CompareFunc(bh->Items[right].Key, bh->Items[_min].Key) < 0)
                 _min = right;
             if (_min == index)
                 break;
@@ -200,9 +196,9 @@ struct BHeap
             int left = _2i + 1;
             int right = _2i + 2;
 
-            if (bh->Items[left].Key > bh->Items[_max].Key)
+            if (bh->CompareFunc(bh->Items[left].Key, bh->Items[_max].Key) > 0)
                 _max = left;
-            if (right < count && bh->Items[right].Key > bh->Items[_max].Key)
+            if (right < count && bh->CompareFunc(bh->Items[right].Key, bh->Items[_max].Key) > 0)
                 _max = right;
             if (_max == index)
                 break;
@@ -0,0 +1,632 @@
+#pragma once
+
+#include "Core.h"
+#include "Jobs.h"
+#include "JobsParallel.h"
+#include "QueueSPSC.h"
+
+// Timing helpers and benchmarks for the threading code. Nothing includes this,
+// call the ones you need from a test build.
+namespace Benchmarks
+{
+
+inline double
+ElapsedMS(u64 osStart)
+{
+	u64 osElapsed = Platform::GetOSTime() - osStart;
+	return 1000.0 * (double)osElapsed / (double)Platform::GetOSFreq();
+}
+
+// Per item cost for the dispatch benchmark, spins for JobIndex dependent amount of work
+struct DispatchBenchmarkCost
+{
+	const char* Name;
+	u32 Spins;
+	bool Skewed; // later items cost up to 8x more, like culling or pathfinding batches
+	u32 JobCount;
+};
+
+internal volatile u32 DispatchBenchmarkSink;
+
+internal void
+DispatchBenchmarkTask(JobArgs* args)
+{
+	const DispatchBenchmarkCost* cost = (const DispatchBenchmarkCost*)args->StackMemory;
+	u32 spins = cost->Spins;
+	if (cost->Skewed)
+		spins += spins * (u32)(((u64)args->JobIndex * 8) / cost->JobCount);
+
+	u32 value = args->JobIndex;
+	for (u32 i = 0; i < spins; ++i)
+		value = value * 1664525u + 1013904223u;
+	DispatchBenchmarkSink = value;
+}
+
+// Compares JobsDispatch at fixed group sizes against JobsDispatchAuto for cheap,
+// medium, heavy and uneven per item costs. Jobs must be initialized.
+inline void
+BenchmarkJobsDispatch(u32 jobCount = 65536, u32 iterations = 10)
+{
+	DispatchBenchmarkCost costs[] =
+	{
+		{ "cheap", 8, false, jobCount },
+		{ "medium", 256, false, jobCount },
+		{ "heavy", 4096, false, jobCount },
+		{ "skewed", 256, true, jobCount },
+	};
+	constexpr u32 groupSizes[] = { 1, 16, 256, 4096 };
+
+	LogInfo("[ Benchmark ] JobsDispatch, %u jobs, %u threads, best of %u", jobCount, JobsGetThreadCount(), iterations);
+
+	for (u32 costIdx = 0; costIdx < ArrayLength(costs); ++costIdx)
+	{
+		DispatchBenchmarkCost* cost = &costs[costIdx];
+
+		for (u32 groupIdx = 0; groupIdx <= ArrayLength(groupSizes); ++groupIdx)
+		{
+			bool isAuto = groupIdx == ArrayLength(groupSizes);
+			double best = 1e30;
+			for (u32 iteration = 0; iteration < iterations; ++iteration)
+			{
+				JobHandle handle = {};
+				u64 start = Platform::GetOSTime();
+				if (isAuto)
+					JobsDispatchAuto(&handle, jobCount, DispatchBenchmarkTask, cost);
+				else
+					JobsDispatch(&handle, jobCount, groupSizes[groupIdx], DispatchBenchmarkTask, cost);
+				JobHandleWait(&handle);
+				double elapsed = ElapsedMS(start);
+				best = Min(best, elapsed);
+			}
+
+			if (isAuto)
+				LogInfo("  %-7s auto        : %.3fms", cost->Name, best);
+			else
+				LogInfo("  %-7s group %-5u : %.3fms", cost->Name, groupSizes[groupIdx], best);
+		}
+	}
+}
+
+struct ScaleBenchmarkData
+{
+	float* Values;
+	float Scale;
+};
+
+internal void
+ScaleBenchmarkTask(JobArgs* args)
+{
+	ScaleBenchmarkData* data = (ScaleBenchmarkData*)args->StackMemory;
+	data->Values[args->JobIndex] *= data->Scale;
+}
+
+internal void
+ScaleBenchmarkRangeTask(JobRangeArgs* args)
+{
+	ScaleBenchmarkData* data = (ScaleBenchmarkData*)args->StackMemory;
+	float* _RESTRICT_ values = data->Values;
+	float scale = data->Scale;
+	for (u32 i = args->Begin; i < args->End; ++i)
+		values[i] *= scale;
+}
+
+// Per index callbacks against range callbacks on a cheap, vectorizable kernel
+inline void
+BenchmarkJobsDispatchRange(Arena* arena, u32 jobCount = 1 << 20, u32 groupSize = 4096, u32 iterations = 10)
+{
+	ScaleBenchmarkData data;
+	data.Values = ArenaPushArrayZero(arena, float, jobCount);
+	data.Scale = 1.0001f;
+
+	LogInfo("[ Benchmark ] JobsDispatchRange, %u floats, group %u, best of %u", jobCount, groupSize, iterations);
+
+	double bestPerIndex = 1e30;
+	double bestRange = 1e30;
+	for (u32 iteration = 0; iteration < iterations; ++iteration)
+	{
+		JobHandle handle = {};
+		u64 start = Platform::GetOSTime();
+		JobsDispatch(&handle, jobCount, groupSize, ScaleBenchmarkTask, &data);
+		JobHandleWait(&handle);
+		double elapsed = ElapsedMS(start);
+		bestPerIndex = Min(bestPerIndex, elapsed);
+
+		start = Platform::GetOSTime();
+		JobsDispatchRange(&handle, jobCount, groupSize, ScaleBenchmarkRangeTask, &data);
+		JobHandleWait(&handle);
+		elapsed = ElapsedMS(start);
+		bestRange = Min(bestRange, elapsed);
+	}
+
+	LogInfo("  per index : %.3fms", bestPerIndex);
+	LogInfo("  range     : %.3fms", bestRange);
+
+	ArenaPop(arena, sizeof(float) * jobCount);
+}
+
+struct ParallelBenchmarkItem
+{
+	u32 Key;
+	u32 Value;
+};
+
+_FORCE_INLINE_ u32
+ParallelBenchmarkHash(u32 value)
+{
+	value ^= value >> 16;
+	value *= 0x7feb352du;
+	value ^= value >> 15;
+	value *= 0x846ca68bu;
+	value ^= value >> 16;
+	return value;
+}
+
+internal void
+ParallelBenchmarkFill(ParallelBenchmarkItem* items, u32 count)
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		items[i].Key = ParallelBenchmarkHash(i);
+		items[i].Value = i;
+	}
+}
+
+internal void
+ParallelBenchmarkLog(const char* name, double serialMS, double parallelMS)
+{
+	LogInfo("  %-10s serial %8.3fms, parallel %8.3fms, %.2fx", name, serialMS, parallelMS, serialMS / Max(parallelMS, 0.001));
+}
+
+// JobsParallel algorithms against plain serial loops doing the same work. Jobs must be initialized.
+inline void
+BenchmarkParallelAlgorithms(Arena* arena, u32 count = 1 << 22, u32 iterations = 5)
+{
+	ArenaSnapshot snapshot = ArenaSnapshotBegin(arena);
+	ParallelBenchmarkItem* items = ArenaPushArray(arena, ParallelBenchmarkItem, count);
+	ParallelBenchmarkItem* temp = ArenaPushArray(arena, ParallelBenchmarkItem, count);
+	u32* values = ArenaPushArray(arena, u32, count);
+	u32* results = ArenaPushArray(arena, u32, count);
+	u32* keys = ArenaPushArray(arena, u32, count);
+
+	StaticHashMap<u32, u32> map = {};
+	size_t mapSize = map.GetMemSize(count * 2);
+	void* mapMemory = ArenaPush(arena, mapSize);
+
+	LogInfo("[ Benchmark ] JobsParallel, %u items, %u threads, best of %u", count, JobsGetThreadCount(), iterations);
+
+	double serial[7];
+	double parallel[7];
+	for (u32 i = 0; i < ArrayLength(serial); ++i)
+	{
+		serial[i] = 1e30;
+		parallel[i] = 1e30;
+	}
+
+	for (u32 iteration = 0; iteration < iterations; ++iteration)
+	{
+		for (u32 i = 0; i < count; ++i)
+			values[i] = i;
+
+		// for-each
+		double elapsed;
+		u64 start = Platform::GetOSTime();
+		for (u32 i = 0; i < count; ++i)
+			values[i] = ParallelBenchmarkHash(values[i]);
+		elapsed = ElapsedMS(start);
+		serial[0] = Min(serial[0], elapsed);
+
+		start = Platform::GetOSTime();
+		ParallelFor(values, count, [](u32& value) { value = ParallelBenchmarkHash(value); });
+		elapsed = ElapsedMS(start);
+		parallel[0] = Min(parallel[0], elapsed);
+
+		// transform
+		start = Platform::GetOSTime();
+		for (u32 i = 0; i < count; ++i)
+			results[i] = values[i] >> 8;
+		elapsed = ElapsedMS(start);
+		serial[1] = Min(serial[1], elapsed);
+
+		start = Platform::GetOSTime();
+		ParallelTransform((const u32*)values, results, count, [](u32 value) { return value >> 8; });
+		elapsed = ElapsedMS(start);
+		parallel[1] = Min(parallel[1], elapsed);
+
+		// reduce, both sides wrap the same u32 sum
+		start = Platform::GetOSTime();
+		u32 sum = 0;
+		for (u32 i = 0; i < count; ++i)
+			sum += results[i];
+		elapsed = ElapsedMS(start);
+		serial[2] = Min(serial[2], elapsed);
+
+		start = Platform::GetOSTime();
+		u32 parallelSum = ParallelReduce((const u32*)results, count, 0u, [](u32 a, u32 b) { return a + b; });
+		elapsed = ElapsedMS(start);
+		parallel[2] = Min(parallel[2], elapsed);
+		if (parallelSum != sum)
+			LogErr("[ Benchmark ] ParallelReduce sum %u, serial sum %u", parallelSum, sum);
+
+		// inclusive scan
+		start = Platform::GetOSTime();
+		u32 running = 0;
+		for (u32 i = 0; i < count; ++i)
+		{
+			running += results[i];
+			keys[i] = running;
+		}
+		elapsed = ElapsedMS(start);
+		serial[3] = Min(serial[3], elapsed);
+
+		start = Platform::GetOSTime();
+		ParallelInclusiveScan((const u32*)results, keys, count, 0u, [](u32 a, u32 b) { return a + b; });
+		elapsed = ElapsedMS(start);
+		parallel[3] = Min(parallel[3], elapsed);
+
+		// stable partition
+		ParallelBenchmarkFill(items, count);
+		start = Platform::GetOSTime();
+		u32 trueCount = 0;
+		for (u32 i = 0; i < count; ++i)
+		{
+			if (items[i].Key & 1)
+				temp[trueCount++] = items[i];
+		}
+		u32 falseIdx = trueCount;
+		for (u32 i = 0; i < count; ++i)
+		{
+			if (!(items[i].Key & 1))
+				temp[falseIdx++] = items[i];
+		}
+		SMemCopy(items, temp, sizeof(ParallelBenchmarkItem) * count);
+		elapsed = ElapsedMS(start);
+		serial[4] = Min(serial[4], elapsed);
+
+		ParallelBenchmarkFill(items, count);
+		start = Platform::GetOSTime();
+		u32 parallelTrueCount = ParallelPartition(items, count, [](const ParallelBenchmarkItem& item) { return (item.Key & 1) != 0; });
+		elapsed = ElapsedMS(start);
+		parallel[4] = Min(parallel[4], elapsed);
+		if (parallelTrueCount != trueCount)
+			LogErr("[ Benchmark ] ParallelPartition split %u, serial split %u", parallelTrueCount, trueCount);
+
+		// stable sort, serial LSD radix sort with the same 8 bit digits
+		ParallelBenchmarkFill(items, count);
+		start = Platform::GetOSTime();
+		ParallelBenchmarkItem* src = items;
+		ParallelBenchmarkItem* dst = temp;
+		for (u32 shift = 0; shift < 32; shift += 8)
+		{
+			u32 offsets[256] = {};
+			for (u32 i = 0; i < count; ++i)
+				++offsets[(src[i].Key >> shift) & 0xFF];
+			u32 offset = 0;
+			for (u32 digit = 0; digit < 256; ++digit)
+			{
+				u32 digitCount = offsets[digit];
+				offsets[digit] = offset;
+				offset += digitCount;
+			}
+			for (u32 i = 0; i < count; ++i)
+				dst[offsets[(src[i].Key >> shift) & 0xFF]++] = src[i];
+			Swap(src, dst);
+		}
+		elapsed = ElapsedMS(start);
+		serial[5] = Min(serial[5], elapsed);
+
+		ParallelBenchmarkFill(items, count);
+		start = Platform::GetOSTime();
+		ParallelSortByKey(items, count, [](const ParallelBenchmarkItem& item) { return item.Key; });
+		elapsed = ElapsedMS(start);
+		parallel[5] = Min(parallel[5], elapsed);
+
+		// hash map build
+		for (u32 i = 0; i < count; ++i)
+			keys[i] = ParallelBenchmarkHash(i);
+
+		map.Init(mapMemory, mapSize, count * 2, 0.85f);
+		SMemZero(mapMemory, mapSize);
+		start = Platform::GetOSTime();
+		for (u32 i = 0; i < count; ++i)
+			map.Add(&keys[i], &values[i]);
+		elapsed = ElapsedMS(start);
+		serial[6] = Min(serial[6], elapsed);
+
+		map.Init(mapMemory, mapSize, count * 2, 0.85f);
+		SMemZero(mapMemory, mapSize);
+		start = Platform::GetOSTime();
+		ParallelHashMapBuild(&map, (const u32*)keys, (const u32*)values, count);
+		elapsed = ElapsedMS(start);
+		parallel[6] = Min(parallel[6], elapsed);
+	}
+
+	const char* names[] = { "for-each", "transform", "reduce", "scan", "partition", "sort", "hash build" };
+	for (u32 i = 0; i < ArrayLength(names); ++i)
+		ParallelBenchmarkLog(names[i], serial[i], parallel[i]);
+
+	ArenaSnapshotEnd(snapshot);
+}
+
+typedef QueueMPMC<u32, 1024> ContentionQueueMPMC;
+typedef QueueThreaded<u32, 1024> ContentionQueueSPMC;
+
+struct QueueContentionContext
+{
+	void* Queue;
+	zpl_mutex* ProducerLock;	// set when the queue only takes one producer at a time
+	u32 ItemsPerProducer;
+	zpl_atomic32 Start;
+	zpl_atomic32 Remaining;		// items not dequeued yet
+	zpl_atomic64 Sum;
+};
+
+template<typename Queue>
+internal zpl_isize
+QueueContentionProducer(zpl_thread* thread)
+{
+	QueueContentionContext* context = (QueueContentionContext*)thread->user_data;
+	Queue* queue = (Queue*)context->Queue;
+	while (!zpl_atomic32_load(&context->Start))
+		zpl_yield_thread();
+
+	for (u32 value = 1; value <= context->ItemsPerProducer; ++value)
+	{
+		for (;;)
+		{
+			bool pushed;
+			if (context->ProducerLock)
+			{
+				zpl_mutex_lock(context->ProducerLock);
+				pushed = queue->Enqueue(&value);
+				zpl_mutex_unlock(context->ProducerLock);
+			}
+			else
+			{
+				pushed = queue->Enqueue(&value);
+			}
+
+			if (pushed)
+				break;
+			zpl_yield_thread();
+		}
+	}
+	return 0;
+}
+
+template<typename Queue>
+internal zpl_isize
+QueueContentionConsumer(zpl_thread* thread)
+{
+	QueueContentionContext* context = (QueueContentionContext*)thread->user_data;
+	Queue* queue = (Queue*)context->Queue;
+	while (!zpl_atomic32_load(&context->Start))
+		zpl_yield_thread();
+
+	u64 sum = 0;
+	while (zpl_atomic32_load(&context->Remaining) > 0)
+	{
+		u32 value;
+		if (queue->Dequeue(&value))
+		{
+			sum += value;
+			zpl_atomic32_fetch_add(&context->Remaining, -1);
+		}
+		else
+		{
+			zpl_yield_thread();
+		}
+	}
+	zpl_atomic64_fetch_add(&context->Sum, (i64)sum);
+	return 0;
+}
+
+// Time until every item went through the queue, 0 if any got lost or duplicated
+template<typename Queue>
+internal double
+QueueContentionRun(Queue* queue, zpl_mutex* producerLock, zpl_thread* threads, u32 producerCount, u32 consumerCount, u32 itemsPerProducer)
+{
+	SMemZero(queue, sizeof(Queue));
+	QueueContentionContext context = {};
+	context.Queue = queue;
+	context.ProducerLock = producerLock;
+	context.ItemsPerProducer = itemsPerProducer;
+	zpl_atomic32_store(&context.Remaining, (i32)(producerCount * itemsPerProducer));
+
+	u32 threadCount = producerCount + consumerCount;
+	for (u32 threadIdx = 0; threadIdx < threadCount; ++threadIdx)
+	{
+		zpl_thread_init(&threads[threadIdx]);
+		zpl_thread_start(&threads[threadIdx], (threadIdx < producerCount) ? QueueContentionProducer<Queue> : QueueContentionConsumer<Queue>, &context);
+	}
+
+	u64 start = Platform::GetOSTime();
+	zpl_atomic32_store(&context.Start, 1);
+	for (u32 threadIdx = 0; threadIdx < threadCount; ++threadIdx)
+	{
+		zpl_thread_join(&threads[threadIdx]);
+		zpl_thread_destroy(&threads[threadIdx]);
+	}
+	double elapsed = ElapsedMS(start);
+
+	u64 expected = (u64)producerCount * itemsPerProducer * (itemsPerProducer + 1) / 2;
+	return ((u64)zpl_atomic64_load(&context.Sum) == expected) ? elapsed : 0.0;
+}
+
+// QueueMPMC against QueueThreaded with its producers taking turns on a mutex, the only
+// safe way to feed the single producer queue from several threads
+inline void
+BenchmarkQueueContention(Arena* arena, u32 producerCount = 4, u32 consumerCount = 4, u32 itemsPerProducer = 1 << 18, u32 iterations = 5)
+{
+	ArenaSnapshot snapshot = ArenaSnapshotBegin(arena);
+	ContentionQueueMPMC* queueMPMC = ArenaPushStruct(arena, ContentionQueueMPMC);
+	ContentionQueueSPMC* queueSPMC = ArenaPushStruct(arena, ContentionQueueSPMC);
+	zpl_thread* threads = ArenaPushArrayZero(arena, zpl_thread, producerCount + consumerCount);
+	zpl_mutex producerLock;
+	zpl_mutex_init(&producerLock);
+
+	LogInfo("[ Benchmark ] Queue contention, %u producers, %u consumers, %u items each, best of %u", producerCount, consumerCount, itemsPerProducer, iterations);
+
+	double bestMPMC = 1e30;
+	double bestSPMC = 1e30;
+	for (u32 iteration = 0; iteration < iterations; ++iteration)
+	{
+		double elapsed = QueueContentionRun(queueMPMC, nullptr, threads, producerCount, consumerCount, itemsPerProducer);
+		if (elapsed == 0.0)
+			LogErr("[ Benchmark ] QueueMPMC lost or duplicated items");
+		else
+			bestMPMC = Min(bestMPMC, elapsed);
+
+		elapsed = QueueContentionRun(queueSPMC, &producerLock, threads, producerCount, consumerCount, itemsPerProducer);
+		if (elapsed == 0.0)
+			LogErr("[ Benchmark ] QueueThreaded lost or duplicated items");
+		else
+			bestSPMC = Min(bestSPMC, elapsed);
+	}
+
+	LogInfo("  QueueMPMC                  : %.3fms", bestMPMC);
+	LogInfo("  QueueThreaded, locked push : %.3fms", bestSPMC);
+
+	zpl_mutex_destroy(&producerLock);
+	ArenaSnapshotEnd(snapshot);
+}
+
+typedef QueueSPSC<u32, 4096> StreamQueueSPSC;
+typedef QueueThreaded<u32, 4096> StreamQueueSPMC;
+
+struct QueueStreamContext
+{
+	void* Queue;
+	u32 ItemCount;
+	u32 Batch;				// 0 moves single items
+	zpl_atomic32 Start;
+};
+
+template<typename Queue>
+internal zpl_isize
+QueueStreamProducer(zpl_thread* thread)
+{
+	QueueStreamContext* context = (QueueStreamContext*)thread->user_data;
+	Queue* queue = (Queue*)context->Queue;
+	while (!zpl_atomic32_load(&context->Start))
+		zpl_yield_thread();
+
+	for (u32 value = 0; value < context->ItemCount;)
+	{
+		if (queue->Enqueue(&value))
+			++value;
+		else
+			zpl_yield_thread();
+	}
+	return 0;
+}
+
+internal zpl_isize
+QueueStreamBatchProducer(zpl_thread* thread)
+{
+	QueueStreamContext* context = (QueueStreamContext*)thread->user_data;
+	StreamQueueSPSC* queue = (StreamQueueSPSC*)context->Queue;
+	while (!zpl_atomic32_load(&context->Start))
+		zpl_yield_thread();
+
+	// Written in place through Reserve, no staging copy
+	for (u32 value = 0; value < context->ItemCount;)
+	{
+		u32 reserved;
+		u32* slots = queue->Reserve(Min(context->Batch, context->ItemCount - value), &reserved);
+		for (u32 i = 0; i < reserved; ++i)
+			slots[i] = value++;
+		if (reserved)
+			queue->Commit(reserved);
+		else
+			zpl_yield_thread();
+	}
+	return 0;
+}
+
+// QueueThreaded has no bulk pop, a batch is taken one item at a time
+_FORCE_INLINE_ u32
+QueueStreamPop(StreamQueueSPMC* queue, u32* values, u32 batch)
+{
+	u32 count = 0;
+	do
+	{
+		if (!queue->Dequeue(&values[count]))
+			break;
+		++count;
+	} while (count < batch);
+	return count;
+}
+
+_FORCE_INLINE_ u32
+QueueStreamPop(StreamQueueSPSC* queue, u32* values, u32 batch)
+{
+	return (batch) ? queue->DequeueMany(values, batch) : (u32)queue->Dequeue(values);
+}
+
+// Items per second through the queue from a producer thread to the calling thread, 0 if
+// any arrived out of order
+template<typename Queue>
+internal double
+QueueStreamRun(Queue* queue, zpl_isize (*producer)(zpl_thread*), u32 itemCount, u32 batch)
+{
+	SMemZero(queue, sizeof(Queue));
+	QueueStreamContext context = {};
+	context.Queue = queue;
+	context.ItemCount = itemCount;
+	context.Batch = batch;
+
+	zpl_thread thread;
+	zpl_thread_init(&thread);
+	zpl_thread_start(&thread, producer, &context);
+
+	u32 values[256];
+	u32 expected = 0;
+	bool inOrder = true;
+	u64 start = Platform::GetOSTime();
+	zpl_atomic32_store(&context.Start, 1);
+	while (expected < itemCount)
+	{
+		u32 count = QueueStreamPop(queue, values, Min(batch, (u32)ArrayLength(values)));
+		if (count == 0)
+			zpl_yield_thread();
+		for (u32 i = 0; i < count; ++i)
+			inOrder &= values[i] == expected++;
+	}
+	double elapsed = ElapsedMS(start);
+
+	zpl_thread_join(&thread);
+	zpl_thread_destroy(&thread);
+	return (inOrder) ? (double)itemCount / (elapsed / 1000.0) : 0.0;
+}
+
+// QueueSPSC one item at a time and batched against QueueThreaded with one producer and
+// one consumer
+inline void
+BenchmarkQueueSPSC(Arena* arena, u32 itemCount = 1 << 24, u32 batch = 64, u32 iterations = 5)
+{
+	ArenaSnapshot snapshot = ArenaSnapshotBegin(arena);
+	StreamQueueSPSC* queueSPSC = ArenaPushStruct(arena, StreamQueueSPSC);
+	StreamQueueSPMC* queueSPMC = ArenaPushStruct(arena, StreamQueueSPMC);
+
+	LogInfo("[ Benchmark ] Single producer single consumer, %u items, batch %u, best of %u", itemCount, batch, iterations);
+
+	double best[3] = {};
+	for (u32 iteration = 0; iteration < iterations; ++iteration)
+	{
+		// One run per call, Max would evaluate it twice
+		double runs[3];
+		runs[0] = QueueStreamRun(queueSPMC, QueueStreamProducer<StreamQueueSPMC>, itemCount, 0);
+		runs[1] = QueueStreamRun(queueSPSC, QueueStreamProducer<StreamQueueSPSC>, itemCount, 0);
+		runs[2] = QueueStreamRun(queueSPSC, QueueStreamBatchProducer, itemCount, batch);
+		for (u32 i = 0; i < ArrayLength(best); ++i)
+			best[i] = Max(best[i], runs[i]);
+	}
+
+	LogInfo("  QueueThreaded       : %.1fM items/s", best[0] / 1e6);
+	LogInfo("  QueueSPSC           : %.1fM items/s", best[1] / 1e6);
+	LogInfo("  QueueSPSC, batched  : %.1fM items/s", best[2] / 1e6);
+
+	ArenaSnapshotEnd(snapshot);
+}
+
+}
@@ -26,7 +26,7 @@ struct DArray
 
         SAssert(newCapacity > 0);
 
-        T* newMemory = ArenaPush(sizeof(T), newCapacity);
+        T* newMemory = ArenaPushArray(arena, T, newCapacity);
         SAssert(newMemory);
         if (Memory)
         {
@@ -45,13 +45,13 @@ struct DArray
             SCAL_ERROR("DArray is full");
             return;
         }
-        Memory[Count] = *valueSrc;
+        Memory[Count] = *value;
         ++Count;
     }
 
     void PushMany(u32 numberToAdd)
     {
-        SAssert(numerToAdd > 0);
+        SAssert(numberToAdd > 0);
 
         u32 roomLeft = Capacity - Count;
         if (numberToAdd > roomLeft)
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "Core.h"
+#include "Arena.h"
+#include "Jobs.h"
 #include "StaticArray.h"
 
+// Ordered by severity, results of a parallel listener batch merge to the most severe
 enum class EventResult
 {
     Ok,
@@ -10,6 +13,12 @@ enum class EventResult
     Cancel,
 };
 
+_FORCE_INLINE_ EventResult
+EventResultMerge(EventResult a, EventResult b)
+{
+    return ((int)a > (int)b) ? a : b;
+}
+
 enum class Events
 {
     AppStart,
@@ -31,11 +40,20 @@ enum EventPriorties
 typedef EventResult EventCallback(void* event, void* stack);
 
 constant_var size_t EVENT_MAX_LISTENERS = 64;
+constant_var size_t EVENT_TYPE_COUNT = (size_t)Events::MaxEvents;
+
+enum ListenerFlags
+{
+    // Does not depend on the other listeners of its priority, EventsTrigger may run it on a
+    // job worker at the same time as its parallel neighbours
+    LISTENER_PARALLEL = 1 << 0,
+};
 
 struct Listener
 {
-    EventCallback Callback;
+    EventCallback* Callback;
     void* UserData;
+    u32 Flags;      // ListenerFlags
 };
 
 struct Event
@@ -45,27 +63,241 @@ struct Event
 
 struct EventManager
 {
-    StaticArray<Event, (size_t)Events::MaxEvents> Events;
+    StaticArray<Event, EVENT_TYPE_COUNT> Events;
 };
 
 global_var EventManager g_EventManager;
 
+// Typed channels. The payload type is known at compile time and listeners are stored densely
+// in priority order, a channel costs MaxListeners entries instead of a full table per type.
+//
+//  EventChannel<WindowResized> OnResize;
+//  OnResize.Add(HandleResize, renderer);
+//  OnResize.Trigger({ width, height });
+template<typename T>
+using EventChannelCallback = EventResult(*)(const T& event, void* userData);
+
+template<typename T, u32 MaxListeners = 8>
+struct EventChannel
+{
+    struct ChannelListener
+    {
+        EventChannelCallback<T> Callback;
+        void* UserData;
+        EventPriorties Priority;
+    };
+
+    ChannelListener Listeners[MaxListeners];
+    u32 Count;
+
+    // After listeners of the same priority. False when the channel is full.
+    bool Add(EventChannelCallback<T> callback, void* userData = nullptr, EventPriorties prio = EVENT_PRIO_NORMAL)
+    {
+        SAssert(callback);
+        if (Count == MaxListeners)
+        {
+            LogErr("EventChannel is full, %u listeners", MaxListeners);
+            return false;
+        }
+
+        u32 idx = Count;
+        while (idx > 0 && Listeners[idx - 1].Priority > prio)
+            --idx;
+        SMemMove(Listeners + idx + 1, Listeners + idx, (Count - idx) * sizeof(ChannelListener));
+        Listeners[idx] = { callback, userData, prio };
+        ++Count;
+        return true;
+    }
+
+    bool Remove(EventChannelCallback<T> callback, void* userData = nullptr)
+    {
+        for (u32 idx = 0; idx < Count; ++idx)
+        {
+            if (Listeners[idx].Callback == callback && Listeners[idx].UserData == userData)
+            {
+                SMemMove(Listeners + idx, Listeners + idx + 1, (Count - idx - 1) * sizeof(ChannelListener));
+                --Count;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Highest priority first, returns the last listener's result like EventsTrigger.
+    // EventResult::Cancel stops the listeners after it.
+    EventResult Trigger(const T& event)
+    {
+        EventResult result = EventResult::Ok;
+        for (u32 idx = 0; idx < Count; ++idx)
+        {
+            result = Listeners[idx].Callback(event, Listeners[idx].UserData);
+            if (result == EventResult::Cancel)
+                break;
+        }
+        return result;
+    }
+};
+
+// Channel whose listeners are fixed at compile time, in call order. Trigger is a direct
+// call to each of them, which the compiler can inline. Results follow EventChannel::Trigger.
+//
+//  using OnAppStart = StaticEventChannel<AppStartEvent, StartAudio, StartRenderer>;
+//  OnAppStart::Trigger(event);
+template<typename T, EventChannelCallback<T>... Callbacks>
+struct StaticEventChannel
+{
+    static _FORCE_INLINE_ EventResult Trigger(const T& event, void* userData = nullptr)
+    {
+        EventResult result = EventResult::Ok;
+        (void)((result = Callbacks(event, userData), result != EventResult::Cancel) && ...);
+        return result;
+    }
+};
+
+// Deferred events. EventsRaise copies the event into a per-frame queue, EventsFlush runs
+// the listeners of everything queued, one event type at a time, so the raise site only
+// pays for an append and each type's handlers run back to back.
+
+// Per type options, set with EventsSetQueueFlags
+enum EventQueueFlags
+{
+    EVENT_QUEUE_COALESCE = 1 << 0,  // identical events raised in one frame are delivered once
+};
+
+constant_var size_t EVENT_QUEUE_CHUNK_SIZE = Kilobytes(16);
+constant_var size_t EVENT_QUEUE_RESERVE_SIZE = Megabytes(64);
+
+// Header in front of each queued event, payloads start SCAL_DEFAULT_ALIGNMENT aligned
+struct EventQueueRecord
+{
+    u32 Size;
+    u32 Hash;   // of the payload, coalescing types only
+};
+
+// Records of one type are appended to a chain of chunks
+struct EventQueueChunk
+{
+    EventQueueChunk* Next;
+    size_t Used;
+    size_t Capacity;
+};
+
+struct EventQueueType
+{
+    EventQueueChunk* First;
+    EventQueueChunk* Last;
+    u32 Count;
+};
+
+struct EventQueueFrame
+{
+    Arena Memory;
+    ArenaSnapshot Start;
+    StaticArray<EventQueueType, EVENT_TYPE_COUNT> Types;
+};
+
+// Two frames, events raised by listeners during EventsFlush go to the other one
+struct EventQueue
+{
+    EventQueueFrame Frames[2];
+    u32 RaiseFrame;
+    StaticArray<u32, EVENT_TYPE_COUNT> Flags;
+};
+
+global_var EventQueue g_EventQueue;
+
+// Runs the listeners of eventType, highest priority first, and returns the last one's result.
+// A listener returning EventResult::Cancel stops the ones after it. Neighbouring
+// LISTENER_PARALLEL listeners of one priority run as a JobsDispatch when Jobs is
+// initialized and are waited on before the next listener. Their results merge into one,
+// a Cancel among them still lets the rest of their batch run.
+inline EventResult EventsTrigger(Events eventType, void* eventData);
+
+inline void EventsRegisterListener(Events eventType, EventPriorties prio, Listener* listener);
+
+// Queues a copy of size bytes of eventData for the next EventsFlush. Main thread only.
+inline void EventsRaise(Events eventType, const void* eventData, u32 size);
+
+template<typename T>
+inline void EventsRaise(Events eventType, const T& eventData) { EventsRaise(eventType, &eventData, (u32)sizeof(T)); }
+
+// EventQueueFlags for a type, applied from the next flush on
+inline void EventsSetQueueFlags(Events eventType, u32 flags);
+
+// Triggers every queued event, type by type in Events order and in raise order within a
+// type, then frees the frame's queue. Call once per frame. Returns how many events ran.
+inline u32 EventsFlush();
+
+// ************************************************************************************
+
+struct EventParallelBatch
+{
+    Listener* Listeners;
+    void* EventData;
+    EventResult* Results;
+};
+
+internal void
+EventParallelListenerTask(JobArgs* args)
+{
+    EventParallelBatch* batch = (EventParallelBatch*)args->StackMemory;
+    Listener* listener = &batch->Listeners[args->JobIndex];
+    batch->Results[args->JobIndex] = listener->Callback(batch->EventData, listener->UserData);
+}
+
+// Runs count listeners as one dispatch and merges their results
+internal EventResult
+EventsTriggerParallel(Listener* listeners, u32 count, void* eventData)
+{
+    EventResult results[EVENT_MAX_LISTENERS];
+    EventParallelBatch batch = { listeners, eventData, results };
+
+    JobHandle handle = {};
+    JobsDispatch(JobsGetCurrentScheduler(), &handle, count, 1, EventParallelListenerTask, &batch);
+    JobHandleWait(&handle);
+
+    EventResult result = EventResult::Ok;
+    for (u32 idx = 0; idx < count; ++idx)
+        result = EventResultMerge(result, results[idx]);
+    return result;
+}
+
 EventResult EventsTrigger(Events eventType, void* eventData)
 {
     Event* event = g_EventManager.Events.At((size_t)eventType);
     SAssert(event);
 
-    EventResult result;
+    bool canDispatch = JobsGetThreadCount(JobsGetCurrentScheduler()) > 0;
+    EventResult result = EventResult::Ok;
 
-    for (size_t prio = 0; 0 < EVENT_PRIO_MAX; ++prio)
+    for (size_t prio = 0; prio < EVENT_PRIO_MAX; ++prio)
     {
-        for (size_t listenerIdx = 0; listenerIdx < event->Priorieties.At(prio)->Count; ++listenerIdx)
+        StaticList<Listener, EVENT_MAX_LISTENERS>* listeners = event->Priorieties.At(prio);
+        for (size_t listenerIdx = 0; listenerIdx < listeners->Count;)
         {
-            Listener* listener = event->Priorieties.At(prio)->At(listenerIdx);
-            SAssert(listener);
+            Listener* listener = listeners->At(listenerIdx);
             SAssert(listener->Callback);
 
-            result = listener->Callback(eventData, listener->UserData);
+            // Gather the run of parallel listeners starting here
+            u32 parallelCount = 0;
+            while (canDispatch && listenerIdx + parallelCount < listeners->Count
+                && (listeners->At(listenerIdx + parallelCount)->Flags & LISTENER_PARALLEL))
+                ++parallelCount;
+
+            // A batch counts as one listener returning its merged result
+            if (parallelCount > 1)
+            {
+                result = EventsTriggerParallel(listener, parallelCount, eventData);
+                listenerIdx += parallelCount;
+            }
+            else
+            {
+                result = listener->Callback(eventData, listener->UserData);
+                ++listenerIdx;
+            }
+
+            if (result == EventResult::Cancel)
+                return result;
         }
     }
 
@@ -77,21 +309,134 @@ void EventsRegisterListener(Events eventType, EventPriorties prio, Listener* lis
     Event* event = g_EventManager.Events.At((size_t)eventType);
     SAssert(event);
 
-    int numOfListeners = event->Priorieties.At(prio)->Count;
+    size_t numOfListeners = event->Priorieties.At(prio)->Count;
     if (numOfListeners < EVENT_MAX_LISTENERS)
     {
         event->Priorieties.At(prio)->Push(listener);
     }
 }
 
-void EventsRegisterListener(Events eventType, EventPriorties prio, Listener* listener)
+_FORCE_INLINE_ size_t
+EventQueueRecordSize(u32 payloadSize)
 {
-    Event* event = g_EventManager.Events.At((size_t)eventType);
-    SAssert(event);
+    return AlignSize(sizeof(EventQueueRecord), SCAL_DEFAULT_ALIGNMENT) + AlignSize(payloadSize, SCAL_DEFAULT_ALIGNMENT);
+}
 
-    int numOfListeners = event->Priorieties.At(prio)->Count;
-    if (numOfListeners < EVENT_MAX_LISTENERS)
+_FORCE_INLINE_ u8*
+EventQueueRecordPayload(EventQueueRecord* record)
+{
+    return (u8*)record + AlignSize(sizeof(EventQueueRecord), SCAL_DEFAULT_ALIGNMENT);
+}
+
+_FORCE_INLINE_ u8*
+EventQueueChunkData(EventQueueChunk* chunk)
+{
+    return (u8*)chunk + AlignSize(sizeof(EventQueueChunk), SCAL_DEFAULT_ALIGNMENT);
+}
+
+void EventsRaise(Events eventType, const void* eventData, u32 size)
+{
+    SAssert((size_t)eventType < EVENT_TYPE_COUNT);
+    SAssert(eventData || size == 0);
+
+    EventQueueFrame* frame = &g_EventQueue.Frames[g_EventQueue.RaiseFrame];
+    if (!frame->Memory.Memory)
     {
-        event->Priorieties.At(prio)->Push(listener);
+        frame->Memory = ArenaCreate(EVENT_QUEUE_RESERVE_SIZE, EVENT_QUEUE_CHUNK_SIZE);
+        frame->Start = ArenaSnapshotBegin(&frame->Memory);
+    }
+
+    EventQueueType* type = frame->Types.At((size_t)eventType);
+    size_t recordSize = EventQueueRecordSize(size);
+    EventQueueChunk* chunk = type->Last;
+    if (!chunk || chunk->Capacity - chunk->Used < recordSize)
+    {
+        size_t capacity = Max(EVENT_QUEUE_CHUNK_SIZE, recordSize);
+        chunk = (EventQueueChunk*)ArenaPush(&frame->Memory, AlignSize(sizeof(EventQueueChunk), SCAL_DEFAULT_ALIGNMENT) + capacity);
+        chunk->Next = nullptr;
+        chunk->Used = 0;
+        chunk->Capacity = capacity;
+        if (type->Last)
+            type->Last->Next = chunk;
+        else
+            type->First = chunk;
+        type->Last = chunk;
     }
+
+    EventQueueRecord* record = (EventQueueRecord*)(EventQueueChunkData(chunk) + chunk->Used);
+    record->Size = size;
+    record->Hash = (*g_EventQueue.Flags.At((size_t)eventType) & EVENT_QUEUE_COALESCE) ? (u32)FNVHash64(eventData, size) : 0;
+    if (size)
+        SMemCopy(EventQueueRecordPayload(record), eventData, size);
+    chunk->Used += recordSize;
+    ++type->Count;
+}
+
+void EventsSetQueueFlags(Events eventType, u32 flags)
+{
+    *g_EventQueue.Flags.At((size_t)eventType) = flags;
+}
+
+// True if an identical record was seen before in this flush, otherwise remembers it.
+// seen is a power of two open addressing table of earlier records.
+internal bool
+EventQueueIsDuplicate(EventQueueRecord** seen, u32 seenCapacity, EventQueueRecord* record)
+{
+    u32 slot = FastModulo(record->Hash, seenCapacity);
+    while (seen[slot])
+    {
+        EventQueueRecord* other = seen[slot];
+        if (other->Hash == record->Hash && other->Size == record->Size
+            && SMemCmp(EventQueueRecordPayload(other), EventQueueRecordPayload(record), record->Size) == 0)
+            return true;
+        slot = FastModulo(slot + 1, seenCapacity);
+    }
+    seen[slot] = record;
+    return false;
+}
+
+u32 EventsFlush()
+{
+    EventQueueFrame* frame = &g_EventQueue.Frames[g_EventQueue.RaiseFrame];
+    if (!frame->Memory.Memory)
+        return 0;
+
+    g_EventQueue.RaiseFrame ^= 1;
+
+    u32 eventCount = 0;
+    for (size_t typeIdx = 0; typeIdx < EVENT_TYPE_COUNT; ++typeIdx)
+    {
+        EventQueueType* type = frame->Types.At(typeIdx);
+        if (!type->Count)
+            continue;
+
+        EventQueueRecord** seen = nullptr;
+        u32 seenCapacity = 0;
+        if (*g_EventQueue.Flags.At(typeIdx) & EVENT_QUEUE_COALESCE)
+        {
+            seenCapacity = 2;
+            while (seenCapacity < type->Count * 2)
+                seenCapacity <<= 1;
+            seen = ArenaPushArrayZero(&frame->Memory, EventQueueRecord*, seenCapacity);
+        }
+
+        for (EventQueueChunk* chunk = type->First; chunk; chunk = chunk->Next)
+        {
+            for (size_t offset = 0; offset < chunk->Used;)
+            {
+                EventQueueRecord* record = (EventQueueRecord*)(EventQueueChunkData(chunk) + offset);
+                offset += EventQueueRecordSize(record->Size);
+                if (seen && EventQueueIsDuplicate(seen, seenCapacity, record))
+                    continue;
+
+                EventsTrigger((Events)typeIdx, EventQueueRecordPayload(record));
+                ++eventCount;
+            }
+        }
+    }
+
+    frame->Types = {};
+    ArenaSnapshotEnd(frame->Start);
+    frame->Start = ArenaSnapshotBegin(&frame->Memory);
+    return eventCount;
 }
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Base.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#pragma comment(lib, "Synchronization.lib")
+#else
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#endif
+
+// Wait on the address of a 32 bit atomic (futex on Linux, WaitOnAddress on Windows).
+// Sleeps only while the value still equals expected, so a waker changes the value
+// before waking. Can return spuriously, callers recheck their condition.
+// timeoutMs < 0 waits forever. Returns false if the timeout expired.
+inline bool
+FutexWait(zpl_atomic32* address, i32 expected, i32 timeoutMs = -1)
+{
+	SAssert(address);
+#ifdef _WIN32
+	DWORD timeout = (timeoutMs < 0) ? INFINITE : (DWORD)timeoutMs;
+	BOOL woken = WaitOnAddress((volatile VOID*)&address->value, &expected, sizeof(i32), timeout);
+	return woken || GetLastError() != ERROR_TIMEOUT;
+#else
+	timespec timeout;
+	timespec* timeoutPtr = nullptr;
+	if (timeoutMs >= 0)
+	{
+		timeout.tv_sec = timeoutMs / 1000;
+		timeout.tv_nsec = (long)(timeoutMs % 1000) * 1000000L;
+		timeoutPtr = &timeout;
+	}
+	long res = syscall(SYS_futex, (i32*)&address->value, FUTEX_WAIT_PRIVATE, expected, timeoutPtr, nullptr, 0);
+	return !(res == -1 && errno == ETIMEDOUT);
+#endif
+}
+
+// Monotonic milliseconds, to keep a deadline across spurious returns of FutexWait
+inline u64
+FutexNowMs()
+{
+#ifdef _WIN32
+	return (u64)GetTickCount64();
+#else
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (u64)now.tv_sec * 1000 + (u64)now.tv_nsec / 1000000;
+#endif
+}
+
+// Wake up to count threads waiting on address
+inline void
+FutexWake(zpl_atomic32* address, i32 count)
+{
+	SAssert(address);
+	if (count <= 0)
+		return;
+#ifdef _WIN32
+	for (i32 i = 0; i < count; ++i)
+		WakeByAddressSingle((PVOID)&address->value);
+#else
+	syscall(SYS_futex, (i32*)&address->value, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#endif
+}
+
+inline void
+FutexWakeAll(zpl_atomic32* address)
+{
+	SAssert(address);
+#ifdef _WIN32
+	WakeByAddressAll((PVOID)&address->value);
+#else
+	syscall(SYS_futex, (i32*)&address->value, FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#endif
+}
@@ -202,7 +202,7 @@ struct StaticHashMap
 
 	void Clear()
 	{
-		for (u32 i = 0; i < map->Capacity; ++i)
+		for (u32 i = 0; i < Capacity; ++i)
 		{
 			Buckets[i].ProbeLength = 0;
 			Buckets[i].IsUsed = 0;
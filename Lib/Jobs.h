@@ -5,11 +5,52 @@
 #include "Core.h"
 
 #include "DArray.h"
+#include "BHeap.h"
 #include "QueueThreaded.h"
+#include "QueueMPMC.h"
+#include "Futex.h"
+
+// Run jobs on fibers. A job that waits on a JobHandle is suspended and its worker
+// keeps running other jobs, the job resumes once the handle's counter reaches zero.
+#ifndef SCAL_JOBS_FIBERS
+#define SCAL_JOBS_FIBERS 0
+#endif
+
+#if SCAL_JOBS_FIBERS && !defined(_WIN32)
+#include <ucontext.h>
+#endif
+
+// Record a per thread timeline of jobs, waits and parked time between JobsTraceStart
+// and JobsTraceStop, viewable with JobsTraceExportChrome
+#ifndef SCAL_JOBS_TRACE
+#define SCAL_JOBS_TRACE 0
+#endif
+
+#if SCAL_JOBS_TRACE
+#include <stdio.h>
+#endif
+
+// What happens to groups that have not started once a handle's deadline passed
+enum JobDeadlinePolicy
+{
+	JOB_DEADLINE_DROP,			// skipped like after JobHandleCancel
+	JOB_DEADLINE_DEPRIORITIZE,	// moved to the background lane
+};
+
+// Defines a state of execution, can be waited on
+struct JobHandle
+{
+	zpl_atomic32 Counter;
+	zpl_atomic32 IsCancelled;
+	u64 Deadline;				// Platform::GetOSTime, 0 for none
+	JobDeadlinePolicy DeadlinePolicy;
+};
 
 struct JobArgs
 {
 	void* StackMemory;		// stack memory shared within the current group (jobs within a group execute serially)
+	const JobHandle* Handle;	// the dispatch's handle, long jobs can check JobHandleIsCancelled
+	Arena* Scratch;			// the worker's scratch arena, rolled back once the group finishes
 	u32 JobIndex;			// job index relative to dispatch (like SV_DispatchThreadID in HLSL)
 	u32 GroupId;			// group index relative to dispatch (like SV_GroupID in HLSL)
 	u32 GroupIndex;			// job index relative to group (like SV_GroupIndex in HLSL)
@@ -17,99 +58,577 @@ struct JobArgs
 	bool IsLastJobInGroup;	// is the current job the last one in the group?
 };
 
+typedef void(*JobWorkFunc)(JobArgs* args);
+
+struct JobRangeArgs
+{
+	void* StackMemory;		// same as JobArgs::StackMemory
+	const JobHandle* Handle;	// same as JobArgs::Handle
+	Arena* Scratch;			// same as JobArgs::Scratch
+	u32 Begin;				// first job index of the group
+	u32 End;				// one past the last job index of the group
+	u32 GroupId;			// group index relative to dispatch
+};
+
+// Called once per group with the whole [Begin, End) range, so the loop over the
+// group's elements lives in the callback and can be vectorized
+typedef void(*JobRangeFunc)(JobRangeArgs* args);
+
+// Workers always take from the highest lane that has work. Lower lanes are aged
+// so they still make progress while the higher lanes stay busy.
+enum JobPriority
+{
+	JOB_PRIORITY_HIGH,			// input, network replies, render submission
+	JOB_PRIORITY_NORMAL,
+	JOB_PRIORITY_LOW,
+	JOB_PRIORITY_BACKGROUND,	// pathfinding, compression, streaming
+
+	JOB_PRIORITY_MAX
+};
+
+// How many jobs a thread takes from higher lanes before it gives a lower lane one turn
+#define JOB_PRIORITY_AGING_LIMIT 32
+
+// Times an idle worker checks the queues before it parks
+#define JOB_PARK_SPIN_COUNT 64
+
+// JobsDispatchAuto never splits below jobCount / (threads * this)
+#define JOB_AUTO_CHUNKS_PER_THREAD 64
+
+// Job scratch arenas, one per thread and with fibers one per fiber. Only address space is
+// reserved up front, pages are committed as jobs use them.
+#ifndef JOB_SCRATCH_RESERVE_SIZE
+#define JOB_SCRATCH_RESERVE_SIZE Megabytes(64)
+#endif
+#define JOB_SCRATCH_COMMIT_SIZE Kilobytes(64)
+
+// Closure jobs keep captures up to this size in the Job itself, larger ones go to the heap
+#define JOB_CLOSURE_INLINE_SIZE 48
+
+struct JobScheduler;
+
+// Calls the closure stored in a job
+typedef void(*JobClosureFunc)(void* closure, JobArgs* args);
+
+// Closures that did not fit inline, freed by whichever group finishes last
+struct JobClosureHeader
+{
+	zpl_atomic32 Refs;
+	void(*Destroy)(JobClosureHeader* header);
+};
+
 struct Job
 {
 	JobWorkFunc task;
+	JobRangeFunc rangeTask;			// set instead of task by the range dispatches
+	JobClosureFunc closure;			// set instead of task by the closure jobs
+	JobClosureHeader* closureHeap;	// null when the closure is stored inline
+	JobScheduler* scheduler;		// whose queues the job and its split halves go to
 	void* stack;
 	JobHandle* handle;
 	u32 GroupId;
 	u32 groupJobOffset;
 	u32 groupJobEnd;
+	u32 splitGrain;			// 0 for a fixed group, otherwise the range is split lazily down to this size
+	JobPriority priority;
+	alignas(SCAL_DEFAULT_ALIGNMENT) u8 closureStorage[JOB_CLOSURE_INLINE_SIZE]; // the closure, or a pointer to it on the heap
 };
 
+static_assert(sizeof(Job) <= 2 * SCAL_CACHE_LINE, "Job should stay within two cache lines");
+
 struct JobQueue
 {
 	#define JOB_QUEUE_SIZE 256
-	QueueThreaded<Job, JOB_QUEUE_SIZE> HighPriorityQueue;
+	QueueMPMC<Job, JOB_QUEUE_SIZE> Lanes[JOB_PRIORITY_MAX];	// any thread submits, the owner and thieves pop
+	zpl_atomic32 HighWater;		// deepest any lane got since the last JobsResetStats, approximate
 
-	_FORCE_INLINE_ void PushBack(const Job& item)
+	// False when the lane is full
+	_FORCE_INLINE_ bool PushBack(const Job& item, JobPriority priority)
 	{
-		bool couldEnqueue = HighPriorityQueue.Enqueue(&item);
-		SAssert(couldEnqueue);
+		bool couldEnqueue = Lanes[priority].Enqueue(&item);
+		return couldEnqueue;
 	}
 
-	_FORCE_INLINE_ bool PopFront(Job& item)
+	_FORCE_INLINE_ bool PopFront(Job& item, JobPriority priority)
 	{
-		bool notEmpty = HighPriorityQueue.Dequeue(&item);
+		bool notEmpty = Lanes[priority].Dequeue(&item);
 		return notEmpty;
 	}
+
+	_FORCE_INLINE_ bool IsEmpty(JobPriority priority)
+	{
+		return Lanes[priority].IsEmpty();
+	}
+
+	_FORCE_INLINE_ int Count(JobPriority priority)
+	{
+		return Lanes[priority].Count();
+	}
+};
+
+// Counters of one thread, only written by that thread. Workers and the thread that called
+// JobsInitialize have them, other threads helping in JobHandleWait are not counted.
+struct JobWorkerStats
+{
+	u64 JobsExecuted;		// groups, and chunks of auto dispatches, run
+	u64 StealAttempts;		// other threads' queues looked at for a job
+	u64 Steals;				// jobs taken from another thread's queue
+	u64 Parks;				// futex waits
+	u64 IdleTicks;			// Platform::GetCPUTime spent parked, spinning or asleep, or in the elastic reserve
+	u64 BusyTicks;			// workers only, the rest of the time since the last reset
+};
+
+// Read with JobsGetStats, the counters keep running while it reads
+struct JobStats
+{
+	JobWorkerStats Total;	// sum over every counted thread
+	u64 Overflows;			// pushes that found a queue full
+	u64 InlineRuns;			// jobs the submitter ran itself because every queue was full
+	u32 QueueHighWater;		// deepest any lane got
+	double ElapsedMs;		// since the last reset
+	double TicksToMs;		// converts IdleTicks and BusyTicks
+};
+
+// A thread's counters and their values at the last reset, a cache line apart from the others
+struct alignas(SCAL_CACHE_LINE) JobStatsSlot
+{
+	JobWorkerStats Counters;
+	JobWorkerStats Baseline;
+	u64 IdleSince;			// Platform::GetCPUTime when the thread parked, 0 outside
+	u64 ReserveTicks;		// part of IdleTicks spent in the elastic reserve
+	bool IsInReserve;		// IdleSince is a reserve park
+};
+
+// Elastic schedulers sample worker utilization every IntervalMs and park surplus workers
+// when it stays low, or bring one back per sample while it stays high with jobs queued.
+// Zero fields take the JOB_ELASTIC_ defaults.
+struct JobElasticPolicy
+{
+	u32 MinThreadCount;		// workers that are never parked
+	u32 IntervalMs;
+	float ShrinkBelow;		// utilization, 0 to 1, under which a sample counts as low
+	float GrowAbove;		// utilization over which a sample counts as high
+	u32 ShrinkSamples;		// low samples in a row before one worker is parked
+	u32 GrowSamples;		// high samples in a row before one worker comes back
+};
+
+#define JOB_ELASTIC_INTERVAL_MS 100
+#define JOB_ELASTIC_SHRINK_BELOW 0.25f
+#define JOB_ELASTIC_GROW_ABOVE 0.85f
+#define JOB_ELASTIC_SHRINK_SAMPLES 10
+#define JOB_ELASTIC_GROW_SAMPLES 1
+
+// Jobs for one thread only. Any thread posts, the owner is the only one that takes.
+struct JobMailbox
+{
+	#define JOB_MAILBOX_SIZE 256
+	zpl_mutex Lock;			// serializes the posting threads
+	QueueThreaded<Job, JOB_MAILBOX_SIZE> Jobs;
+};
+
+// Mailbox target of the thread that called JobsInitialize
+#define JOB_THREAD_MAIN 0xFFFFFFFFu
+
+// Timers pending at once per scheduler, ids keep the index in 16 bits
+#define JOB_TIMER_COUNT 256
+
+// Most timers one poll turns into jobs, the rest fire on the next poll
+#define JOB_TIMER_FIRE_BATCH 16
+
+// 0 is never a valid id
+typedef u32 JobTimerId;
+
+// A JobsExecuteAt or JobsExecuteEvery job waiting in the scheduler's heap
+struct JobTimer
+{
+	u64 Due;				// Platform::GetOSTime
+	u64 Period;				// OS ticks, 0 for a one-shot timer
+	JobHandle* Handle;
+	JobWorkFunc Task;		// null once cancelled or free
+	void* Stack;
+	JobPriority Priority;
+	u16 Generation;			// bumped when freed, so stale ids do not cancel the next user
+	JobTimer* Next;
+};
+
+#if SCAL_JOBS_FIBERS
+#define JOB_FIBER_COUNT 128
+#define JOB_FIBER_STACK_SIZE Kilobytes(64)
+
+// Schedulers running at once, including the default JobsState
+#define JOB_SCHEDULER_MAX 8
+
+// Every fiber runs the worker loop. When a job waits, its fiber is parked on the
+// handle and the worker switches to a free fiber that carries on with the loop.
+struct JobFiber
+{
+#ifdef _WIN32
+	void* Handle;
+#else
+	ucontext_t Context;
+	void* Stack;
+#endif
+	const JobHandle* WaitingOn;
+	JobFiber* Next;
+	Arena Scratch;	// travels with the job when it resumes on another thread
+};
+
+// What the fiber we switched away from needs, done once we are off its stack
+enum JobFiberAction
+{
+	JOB_FIBER_ACTION_NONE,
+	JOB_FIBER_ACTION_FREE,
+	JOB_FIBER_ACTION_WAIT,
+};
+#endif
+
+#if SCAL_JOBS_TRACE
+// Events kept per thread, older ones are overwritten. Power of 2.
+#ifndef JOB_TRACE_CAPACITY
+#define JOB_TRACE_CAPACITY 16384
+#endif
+
+enum JobTraceType : u8
+{
+	JOB_TRACE_POP,			// job taken from Queue, Depth jobs were left on its lane
+	JOB_TRACE_JOB_BEGIN,	// one group, or one chunk of an auto dispatch
+	JOB_TRACE_JOB_END,
+	JOB_TRACE_WAIT_BEGIN,	// JobHandleWait on Handle
+	JOB_TRACE_WAIT_END,
+	JOB_TRACE_SUSPEND,		// fiber parked on Handle, the job continues elsewhere
+	JOB_TRACE_PARK_BEGIN,	// worker asleep on the futex
+	JOB_TRACE_PARK_END,
+};
+
+struct JobTraceEvent
+{
+	u64 Time;				// Platform::GetCPUTime
+	const void* Handle;
+	u32 GroupId;
+	u16 Queue;
+	u16 Depth;
+	JobTraceType Type;
+	u8 Priority;
+};
+
+// Written only by the owning thread
+struct JobTraceBuffer
+{
+	JobTraceEvent* Events;
+	u64 Count;
+	JobScheduler* Scheduler;	// whose JobsTraceStart enables it
+};
+#endif
+
+// Scheduling state of the current thread, kept by workers and by any thread
+// that helps out inside JobHandleWait
+struct JobsThreadState
+{
+	u32 LaneSkips[JOB_PRIORITY_MAX]; // jobs taken from higher lanes since this lane last had a turn
+	JobScheduler* Scheduler;		// scheduler the thread works for, null for threads that are not workers
+	u32 QueueIndex;					// the worker's own queue, 0 for other threads
+	Arena Scratch;					// created on the first job the thread runs
+#if SCAL_JOBS_FIBERS
+	JobFiber* CurrentFiber;			// null when the thread is not running the fiber loop
+	JobFiber* PreviousFiber;
+	JobFiberAction PreviousAction;
+	JobFiber ThreadFiber;			// the thread's own context, returned to on shutdown
+#endif
+#if SCAL_JOBS_TRACE
+	JobTraceBuffer* TraceBuffer;	// null for threads that are not traced
+#endif
+};
+
+inline thread_local JobsThreadState JobsLocalState;
+
+#if SCAL_JOBS_FIBERS
+// Fibers can resume on another thread, the TLS address must not be cached across a switch
+_NEVER_INLINE_ JobsThreadState*
+JobsGetLocalState()
+{
+	JobsThreadState* volatile state = &JobsLocalState;
+	return state;
+}
+#else
+_FORCE_INLINE_ JobsThreadState*
+JobsGetLocalState()
+{
+	return &JobsLocalState;
+}
+#endif
+
+// Options for JobsInitialize. Cpus pins worker i to Cpus[i % CpuCount] (a cpu number on Linux,
+// a bit of the affinity mask on Windows), null keeps the default placement.
+struct JobSchedulerDesc
+{
+	u32 MaxThreadCount;
+	const u32* Cpus;
+	u32 CpuCount;
+	const char* Name;		// prefix of the worker thread names, "Job" when null
 };
 
-// Manages internal state and thread management. Will handle joining and destroying threads
-// when finished.
-struct JobsInternalState
+// A pool of workers with its own queues. Manages internal state and thread management,
+// will handle joining and destroying threads when finished. JobsState is the default one.
+struct JobScheduler
 {
+	const char* Name;
 	u32 NumCores;
 	u32 NumThreads;
 	DArray<zpl_thread> Threads;
 	JobQueue* JobQueuePerThread;
 	zpl_atomic32 IsAlive;
 	zpl_atomic32 NextQueueIndex;
+	zpl_atomic32 WakeEpoch;			// futex parked workers sleep on, bumped to wake them
+	zpl_atomic32 SleepingCount;		// workers parked or about to park
+	zpl_mutex TimerLock;			// guards the timer heap and free list
+	BHeap TimerHeap;				// pending timers, earliest due first
+	JobTimer* Timers;
+	JobTimer* FreeTimers;
+	zpl_atomic32 TimerCount;		// timers in the heap, 0 skips polling
+	zpl_atomic64 NextTimerDue;		// due time of the earliest timer
+	JobMailbox* Mailboxes;			// one per worker, then one for the main thread
+	JobStatsSlot* Stats;			// laid out like Mailboxes
+	zpl_atomic32 ActiveThreads;		// workers taking jobs, the others sleep on ReserveEpoch
+	zpl_atomic32 ReserveEpoch;
+	JobElasticPolicy Elastic;
+	JobTimerId ElasticTimer;		// 0 when the worker count is fixed
+	JobHandle ElasticHandle;
+	u64 ElasticLastCPU;
+	u64 ElasticLastIdle;
+	u32 ElasticLowSamples;
+	u32 ElasticHighSamples;
+	zpl_atomic64 Overflows;
+	zpl_atomic64 InlineRuns;
+	u64 StatsResetCPU;
+	u64 StatsResetOS;
+	JobsThreadState* MainThreadState;	// the thread that called JobsInitialize
+#if SCAL_JOBS_FIBERS
+	zpl_mutex FiberLock;			// guards the fiber lists
+	JobFiber* FreeFibers;
+	JobFiber* WaitingFibers;
+	JobFiber* ReadyFibersFirst;
+	JobFiber* ReadyFibersLast;
+	zpl_atomic32 WaitingFiberCount;
+	zpl_atomic32 ReadyFiberCount;
+#endif
+#if SCAL_JOBS_TRACE
+	JobTraceBuffer* TraceBuffers;	// one per worker, then one for the thread that called JobsInitialize
+	zpl_atomic32 TraceEnabled;
+	u64 TraceStartCPU;
+	u64 TraceStartOS;
+	u64 TraceStopCPU;
+	u64 TraceStopOS;
+#endif
 
-	JobsInternalState()
+	JobScheduler()
 	{
+		Name = "Job";
 		NumCores = 0;
 		NumThreads = 0;
 		JobQueuePerThread = nullptr;
 		Threads = {};
 		IsAlive = {};
 		NextQueueIndex = {};
+		WakeEpoch = {};
+		SleepingCount = {};
 		zpl_atomic32_store(&IsAlive, 1);
+		zpl_mutex_init(&TimerLock);
+		TimerHeap = {};
+		Timers = nullptr;
+		FreeTimers = nullptr;
+		TimerCount = {};
+		NextTimerDue = {};
+		Mailboxes = nullptr;
+		MainThreadState = nullptr;
+		Stats = nullptr;
+		ActiveThreads = {};
+		ReserveEpoch = {};
+		Elastic = {};
+		ElasticTimer = 0;
+		ElasticHandle = {};
+		ElasticLastCPU = 0;
+		ElasticLastIdle = 0;
+		ElasticLowSamples = 0;
+		ElasticHighSamples = 0;
+		Overflows = {};
+		InlineRuns = {};
+		StatsResetCPU = 0;
+		StatsResetOS = 0;
+#if SCAL_JOBS_FIBERS
+		zpl_mutex_init(&FiberLock);
+		FreeFibers = nullptr;
+		WaitingFibers = nullptr;
+		ReadyFibersFirst = nullptr;
+		ReadyFibersLast = nullptr;
+		WaitingFiberCount = {};
+		ReadyFiberCount = {};
+#endif
+#if SCAL_JOBS_TRACE
+		TraceBuffers = nullptr;
+		TraceEnabled = {};
+		TraceStartCPU = 0;
+		TraceStartOS = 0;
+		TraceStopCPU = 0;
+		TraceStopOS = 0;
+#endif
 
 		LogInfo("[ Jobs ] Thread state initialized!");
 	}
 
-	~JobsInternalState()
-	{
-		zpl_atomic32_store(&IsAlive, 0); // indicate that new jobs cannot be started from this point
+	~JobScheduler();
+};
 
-		for (int i = 0; i < Threads.Count; ++i)
-		{
-			zpl_semaphore_post(&Threads.At(i)->semaphore, 1);
-			zpl_thread_join(Threads.At(i));
-			zpl_thread_destroy(Threads.At(i));
-		}
+internal JobScheduler JobsState;
 
-		LogInfo("[ Jobs ] Thread state shutdown!");
-	}
-};
+#if SCAL_JOBS_TRACE
+_FORCE_INLINE_ void
+JobsTraceRecord(JobTraceType type, const void* handle, u32 groupId, u32 priority, u32 queue = 0, u32 depth = 0)
+{
+	JobTraceBuffer* buffer = JobsGetLocalState()->TraceBuffer;
+	if (!buffer || !zpl_atomic32_load(&buffer->Scheduler->TraceEnabled))
+		return;
 
-internal JobsInternalState JobsState;
+	JobTraceEvent* event = &buffer->Events[buffer->Count & (JOB_TRACE_CAPACITY - 1)];
+	event->Time = Platform::GetCPUTime();
+	event->Handle = handle;
+	event->GroupId = groupId;
+	event->Queue = (u16)queue;
+	event->Depth = (u16)Min(depth, 0xFFFFu);
+	event->Type = type;
+	event->Priority = (u8)priority;
+	++buffer->Count;
+}
 
-void JobsInitialize(u32 maxThreadCount);
+#define JOB_TRACE(...) JobsTraceRecord(__VA_ARGS__)
+#else
+#define JOB_TRACE(...)
+#endif
 
-u32 JobsGetThreadCount();
+// Initialize the default scheduler, JobsState
+void JobsInitialize(Arena* arena, u32 maxThreadCount);
 
-// Defines a state of execution, can be waited on
-struct JobHandle
-{
-	zpl_atomic32 Counter;
-};
+// Start the workers of another scheduler, e.g. to keep background work on chosen cores.
+// Queues, fibers and trace buffers come from arena. Every call below without a scheduler
+// goes to JobsState.
+void JobsInitialize(JobScheduler* scheduler, Arena* arena, const JobSchedulerDesc& desc);
 
-typedef void(*JobWorkFunc)(JobArgs* args);
+// Join the scheduler's workers, jobs still queued or in mailboxes run on the calling thread and
+// pending timers are dropped. With fibers, jobs suspended in JobHandleWait finish first. Jobs must not be submitted to it afterwards. Called by the destructor, so only needed for schedulers that go
+// away before the program ends or are started again.
+void JobsShutdown(JobScheduler* scheduler);
+
+u32 JobsGetThreadCount();
+u32 JobsGetThreadCount(JobScheduler* scheduler);
+
+// The scheduler of the calling worker, JobsState on threads that are not workers. Jobs that
+// dispatch more work can use it to stay on their own pool.
+inline JobScheduler* JobsGetCurrentScheduler();
 
 // Add a task to execute asynchronously. Any idle thread will execute this.
-inline void JobsExecute(JobHandle* handle, JobWorkFunc task, void* stack);
+inline void JobsExecute(JobHandle* handle, JobWorkFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+inline void JobsExecute(JobScheduler* scheduler, JobHandle* handle, JobWorkFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
 
 // Divide a task onto multiple jobs and execute in parallel.
 //	jobCount	: how many jobs to generate for this task.
 //	groupSize	: how many jobs to execute per thread. Jobs inside a group execute serially. It might be worth to increase for small jobs
 //	task		: receives a JobArgs as parameter
-inline void JobsDispatch(JobHandle* handle, u32 jobCount, u32 groupSize, JobWorkFunc task, void* stack);
+//	priority	: lane every group of this dispatch is queued on
+inline void JobsDispatch(JobHandle* handle, u32 jobCount, u32 groupSize, JobWorkFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+inline void JobsDispatch(JobScheduler* scheduler, JobHandle* handle, u32 jobCount, u32 groupSize, JobWorkFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+
+// Like JobsDispatch, but the scheduler picks the group size. The whole range is queued as one
+// job and split in half whenever the thread running it has nothing queued for others to steal,
+// so idle workers get work without callers tuning groupSize. GroupId is the index of the chunk
+// the job belongs to.
+inline void JobsDispatchAuto(JobHandle* handle, u32 jobCount, JobWorkFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+inline void JobsDispatchAuto(JobScheduler* scheduler, JobHandle* handle, u32 jobCount, JobWorkFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+
+// Same as JobsDispatch, but task is called once per group with the group's index range
+// instead of once per job
+inline void JobsDispatchRange(JobHandle* handle, u32 jobCount, u32 groupSize, JobRangeFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+inline void JobsDispatchRange(JobScheduler* scheduler, JobHandle* handle, u32 jobCount, u32 groupSize, JobRangeFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+
+// Same as JobsDispatchAuto, but task is called once per chunk with the chunk's index range
+inline void JobsDispatchRangeAuto(JobHandle* handle, u32 jobCount, JobRangeFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+inline void JobsDispatchRangeAuto(JobScheduler* scheduler, JobHandle* handle, u32 jobCount, JobRangeFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+
+// Like JobsExecute, but runs a callable, fn(), with its captures copied into the job. Captures
+// that are trivially copyable and fit JOB_CLOSURE_INLINE_SIZE need no allocation, others are
+// copied to the heap once.
+template<typename Fn>
+inline void JobsExecuteClosure(JobHandle* handle, const Fn& fn, JobPriority priority = JOB_PRIORITY_NORMAL);
+template<typename Fn>
+inline void JobsExecuteClosure(JobScheduler* scheduler, JobHandle* handle, const Fn& fn, JobPriority priority = JOB_PRIORITY_NORMAL);
+
+// Like JobsDispatch, but runs a callable, fn(JobArgs* args), stored like JobsExecuteClosure.
+// Every group gets its own inline copy or shares the one heap copy.
+template<typename Fn>
+inline void JobsDispatchClosure(JobHandle* handle, u32 jobCount, u32 groupSize, const Fn& fn, JobPriority priority = JOB_PRIORITY_NORMAL);
+template<typename Fn>
+inline void JobsDispatchClosure(JobScheduler* scheduler, JobHandle* handle, u32 jobCount, u32 groupSize, const Fn& fn, JobPriority priority = JOB_PRIORITY_NORMAL);
+
+// Like JobsExecute, but the job is queued once Platform::GetOSTime() reaches osTime. The
+// handle counts it from now, so waiting on it waits for the timer too. Timers are checked
+// between jobs and by idle workers, which sleep no longer than the earliest timer, so no
+// thread is spent on them. Returns 0 when all JOB_TIMER_COUNT timers are in use.
+inline JobTimerId JobsExecuteAt(JobHandle* handle, u64 osTime, JobWorkFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+inline JobTimerId JobsExecuteAt(JobScheduler* scheduler, JobHandle* handle, u64 osTime, JobWorkFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+
+// Queue the job every periodMs, the first time one period from now, until the timer is
+// cancelled. The handle counts the runs in flight. Periods missed while the workers were
+// busy are skipped rather than run back to back.
+inline JobTimerId JobsExecuteEvery(JobHandle* handle, u32 periodMs, JobWorkFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+inline JobTimerId JobsExecuteEvery(JobScheduler* scheduler, JobHandle* handle, u32 periodMs, JobWorkFunc task, void* stack, JobPriority priority = JOB_PRIORITY_NORMAL);
+
+// Stop a timer before its next run, a run already queued still happens. A cancelled one-shot
+// timer releases its handle. False if the timer already fired for the last time.
+inline bool JobsTimerCancel(JobTimerId id);
+inline bool JobsTimerCancel(JobScheduler* scheduler, JobTimerId id);
+
+// Run the job on one thread: threadIdx is a worker of the scheduler, or JOB_THREAD_MAIN for
+// the thread that called JobsInitialize. Workers take their mailbox before the queues, the
+// main thread empties its own in JobHandleWait and JobsPumpMainThread. With fibers a job that
+// waits can resume elsewhere, so thread bound work should not wait. While the mailbox is
+// full the caller runs other jobs of the scheduler, or the job itself if the mailbox is its own.
+inline void JobsExecuteOnThread(JobHandle* handle, u32 threadIdx, JobWorkFunc task, void* stack);
+inline void JobsExecuteOnThread(JobScheduler* scheduler, JobHandle* handle, u32 threadIdx, JobWorkFunc task, void* stack);
+
+// Run what was posted to the main thread, call it from the main thread's loop. Returns how
+// many jobs ran.
+inline u32 JobsPumpMainThread(JobScheduler* scheduler = &JobsState);
+
+// Sum the counters since the last reset. perThread, if given, receives up to perThreadCount
+// threads' own counters: the workers, then the thread that called JobsInitialize.
+inline void JobsGetStats(JobStats* stats, JobWorkerStats* perThread = nullptr, u32 perThreadCount = 0, JobScheduler* scheduler = &JobsState);
+
+// Start counting from zero, e.g. once per frame. Counters are not cleared, the current values
+// become the baseline, so threads can keep writing without locks.
+inline void JobsResetStats(JobScheduler* scheduler = &JobsState);
+
+// Let the worker count follow the load, between policy->MinThreadCount and the count the
+// scheduler was started with. Parked workers sleep apart from the idle ones, so new jobs do
+// not wake them. Null goes back to a fixed count with every worker active.
+inline void JobsSetElasticPolicy(const JobElasticPolicy* policy, JobScheduler* scheduler = &JobsState);
+
+// Workers currently taking jobs
+inline u32 JobsGetActiveThreadCount(JobScheduler* scheduler = &JobsState);
 
 // Returns the amount of job groups that will be created for a set number of jobs and group size
 inline u32 JobsDispatchGroupCount(u32 jobCount, u32 groupSize);
 
+#if SCAL_JOBS_TRACE
+// Start recording, events from before are left out of the export
+void JobsTraceStart(JobScheduler* scheduler = &JobsState);
+
+// Stop recording, also calibrates the cpu timer against the OS timer for the export
+void JobsTraceStop(JobScheduler* scheduler = &JobsState);
+
+// Write what was recorded between the last start and stop as Chrome trace-event JSON, open it
+// in chrome://tracing or ui.perfetto.dev. Call while no jobs run, each thread keeps only its last
+// JOB_TRACE_CAPACITY events. With fibers a job is cut where it suspends, its remainder is not drawn.
+bool JobsTraceExportChrome(const char* path, JobScheduler* scheduler = &JobsState);
+#endif
+
 // Check if any threads are working currently or not
 _FORCE_INLINE_ bool
 JobHandleIsBusy(const JobHandle* handle)
@@ -118,21 +637,46 @@ JobHandleIsBusy(const JobHandle* handle)
 	return zpl_atomic32_load(&handle->Counter) > 0;
 }
 
+// Skip every group of the handle that has not started yet, the counter still reaches zero.
+// Groups already running finish unless they check JobHandleIsCancelled themselves.
+_FORCE_INLINE_ void
+JobHandleCancel(JobHandle* handle)
+{
+	zpl_atomic32_store(&handle->IsCancelled, 1);
+}
+
+_FORCE_INLINE_ bool
+JobHandleIsCancelled(const JobHandle* handle)
+{
+	return zpl_atomic32_load(&handle->IsCancelled) != 0;
+}
+
+// Groups that have not started by osTime (Platform::GetOSTime) are dropped or deprioritized.
+// Set it before the dispatch, a reused handle keeps it until reset with {}.
+_FORCE_INLINE_ void
+JobHandleSetDeadline(JobHandle* handle, u64 osTime, JobDeadlinePolicy policy = JOB_DEADLINE_DROP)
+{
+	handle->Deadline = osTime;
+	handle->DeadlinePolicy = policy;
+}
+
 // Wait until all threads become idle
-// Current thread will become a worker thread, executing jobs
+// Current thread will become a worker thread, executing jobs of its current scheduler. With
+// SCAL_JOBS_FIBERS a job waiting on a worker is suspended instead, and the worker runs other
+// jobs meanwhile.
 inline void JobHandleWait(const JobHandle* handle);
 
 #ifdef _WIN32
 #include <Windows.h>
 
-inline void Win32_InitThread(void* handle, unsigned int threadID)
+inline void Win32_InitThread(void* handle, unsigned int threadID, unsigned int cpu, const char* namePrefix)
 {
 	SAssert(handle);
 	// Do Windows-specific thread setup:
 	HANDLE winHandle = (HANDLE)handle;
 
 	// Put each thread on to dedicated core:
-	DWORD_PTR affinityMask = 1ull << threadID;
+	DWORD_PTR affinityMask = 1ull << cpu;
 	DWORD_PTR affinity_result = SetThreadAffinityMask(winHandle, affinityMask);
 	SAssert(affinity_result > 0);
 
@@ -141,195 +685,1883 @@ inline void Win32_InitThread(void* handle, unsigned int threadID)
 	//assert(priority_result != 0);
 	// Name the thread:
 	WCHAR buffer[31] = {};
-	wsprintfW(buffer, L"Job_%d", threadID);
+	wsprintfW(buffer, L"%S_%d", namePrefix, threadID);
 	HRESULT hr = SetThreadDescription(winHandle, buffer);
 	SAssert(SUCCEEDED(hr));
 }
 #endif
 #ifdef PLATFORM_LINUX
 #include <pthread.h>
-#endif
+#include <sched.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-//	Start working on a job queue
-//	After the job queue is finished, it can switch to an other queue and steal jobs from there
-internal void 
-Work(u32 startingQueue)
+struct LinuxCpuInfo
+{
+	int Cpu;
+	int CoreId;		// first cpu of the core's SMT siblings
+	int L3Id;		// first cpu sharing the L3 cache (a CCX on AMD), -1 if unknown
+	int PackageId;
+	int SmtIndex;	// 0 for the first hardware thread of a core
+};
+
+// Cpus this process may run on, ordered for worker placement: one hardware thread
+// per physical core first, grouped by package and L3 so neighbouring queues share
+// a cache, then the SMT siblings in the same order
+struct LinuxCpuTopology
 {
-	for (u32 i = 0; i < JobsState.NumThreads; ++i)
+	LinuxCpuInfo Cpus[CPU_SETSIZE];
+	u32 CpuCount;
+	u32 PhysicalCoreCount;
+	u32 L3Count;
+	u32 QuotaCpus;	// cgroup cpu quota rounded up, 0 when unlimited
+};
+
+// Read the first integer of a sysfs or cgroup file, fallback if missing
+internal int
+Linux_ReadFirstInt(const char* path, int fallback)
+{
+	FILE* file = fopen(path, "r");
+	if (!file)
+		return fallback;
+
+	int value;
+	if (fscanf(file, "%d", &value) != 1)
+		value = fallback;
+	fclose(file);
+	return value;
+}
+
+internal u32
+Linux_QueryCgroupQuota()
+{
+	// cgroup v2, "max 100000" when unlimited
+	FILE* file = fopen("/sys/fs/cgroup/cpu.max", "r");
+	if (file)
 	{
-		Job job;
-		JobQueue* job_queue = &JobsState.JobQueuePerThread[startingQueue % JobsState.NumThreads];
-		while (job_queue->PopFront(job))
+		char quota[32] = {};
+		long long period = 0;
+		int read = fscanf(file, "%31s %lld", quota, &period);
+		fclose(file);
+		if (read == 2 && period > 0 && strcmp(quota, "max") != 0)
 		{
-			SAssert(job.task);
-
-			for (u32 j = job.groupJobOffset; j < job.groupJobEnd; ++j)
-			{
-				JobArgs args;
-				args.GroupId = job.GroupId;
-				args.StackMemory = job.stack;
-				args.JobIndex = j;
-				args.GroupIndex = j - job.groupJobOffset;
-				args.IsFirstJobInGroup = (j == job.groupJobOffset);
-				args.IsLastJobInGroup = (j == job.groupJobEnd - 1);
-				job.task(&args);
-			}
-			zpl_atomic32_fetch_add(&job.handle->Counter, -1);
+			long long quotaUs = atoll(quota);
+			return (u32)((quotaUs + period - 1) / period);
 		}
-		++startingQueue; // go to next queue
+		return 0;
 	}
+
+	// cgroup v1, -1 when unlimited
+	int quotaUs = Linux_ReadFirstInt("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", -1);
+	int periodUs = Linux_ReadFirstInt("/sys/fs/cgroup/cpu/cpu.cfs_period_us", -1);
+	if (quotaUs > 0 && periodUs > 0)
+		return (u32)((quotaUs + periodUs - 1) / periodUs);
+
+	return 0;
 }
 
-void JobsInitialize(Arena* arena, u32 maxThreadCount)
+_FORCE_INLINE_ bool
+Linux_CpuPlacedBefore(const LinuxCpuInfo& a, const LinuxCpuInfo& b)
 {
-	if (JobsState.NumThreads > 0)
+	if (a.SmtIndex != b.SmtIndex) return a.SmtIndex < b.SmtIndex;
+	if (a.PackageId != b.PackageId) return a.PackageId < b.PackageId;
+	if (a.L3Id != b.L3Id) return a.L3Id < b.L3Id;
+	return a.Cpu < b.Cpu;
+}
+
+internal void
+Linux_QueryTopology(LinuxCpuTopology* topology)
+{
+	SAssert(topology);
+	topology->CpuCount = 0;
+	topology->PhysicalCoreCount = 0;
+	topology->L3Count = 0;
+	topology->QuotaCpus = Linux_QueryCgroupQuota();
+
+	// Honors taskset and the cgroup cpuset
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
 	{
-		SCAL_ERROR("Job internal state already initialized");
+		LogErr("[ Jobs ] sched_getaffinity failed, errno %d", errno);
 		return;
 	}
 
-	SAssert(maxThreadCount > 0);
-
-	float startTime = GetTime();
+	char path[128];
+	for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+	{
+		if (!CPU_ISSET(cpu, &allowed))
+			continue;
 
-	maxThreadCount = Max(1u, maxThreadCount);
+		LinuxCpuInfo* info = &topology->Cpus[topology->CpuCount++];
+		info->Cpu = cpu;
 
-	zpl_affinity affinity;
-	zpl_affinity_init(&affinity);
+		zpl_snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+		info->CoreId = Linux_ReadFirstInt(path, cpu);
 
-	u32 coreCount = (u32)affinity.core_count;
-	u32 threadCount = (u32)affinity.thread_count;
+		zpl_snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+		info->PackageId = Linux_ReadFirstInt(path, 0);
 
-	zpl_affinity_destroy(&affinity);
+		zpl_snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index3/shared_cpu_list", cpu);
+		info->L3Id = Linux_ReadFirstInt(path, -1);
 
-	if (coreCount == 0)
-	{
-		SCAL_ERROR("coreCount == 0");
+		info->SmtIndex = 0;
 	}
 
-	JobsState.NumCores = coreCount;
-	// -2, 1 for main thread, 1 so pc can do other things
-	JobsState.NumThreads = ClampValue(threadCount - 2, 1, maxThreadCount);
+	// SMT index within the allowed siblings of each core
+	for (u32 i = 0; i < topology->CpuCount; ++i)
+	{
+		LinuxCpuInfo* info = &topology->Cpus[i];
+		for (u32 j = 0; j < i; ++j)
+		{
+			if (topology->Cpus[j].CoreId == info->CoreId)
+				++info->SmtIndex;
+		}
+		if (info->SmtIndex == 0)
+			++topology->PhysicalCoreCount;
 
-	JobsState.JobQueuePerThread = ArenaPushArray(arena, JobQueue, JobsState.NumThreads);
-    JobsState.Threads.Resize(arena, JobsState.NumThreads);
-	SAssert(JobsState.Threads);
+		bool isNewL3 = true;
+		for (u32 j = 0; j < i; ++j)
+		{
+			if (topology->Cpus[j].L3Id == info->L3Id)
+				isNewL3 = false;
+		}
+		if (isNewL3)
+			++topology->L3Count;
+	}
 
-	for (u32 threadIdx = 0; threadIdx < JobsState.NumThreads; ++threadIdx)
+	for (u32 i = 1; i < topology->CpuCount; ++i)
 	{
-		zpl_thread* thread = JobsState.Threads.At(threadIdx);
-		zpl_thread_init(thread);
+		LinuxCpuInfo info = topology->Cpus[i];
+		u32 j = i;
+		while (j > 0 && Linux_CpuPlacedBefore(info, topology->Cpus[j - 1]))
+		{
+			topology->Cpus[j] = topology->Cpus[j - 1];
+			--j;
+		}
+		topology->Cpus[j] = info;
+	}
+}
 
-		zpl_thread_start_with_stack(thread, [](zpl_thread* thread)
-			{
-				u32* threadIdx = (u32*)thread->user_data;
+inline void Linux_InitThread(pthread_t handle, unsigned int threadID, int cpu, const char* namePrefix)
+{
+	// Pin to one cpu
+	cpu_set_t cpuset;
+	CPU_ZERO(&cpuset);
+	CPU_SET(cpu, &cpuset);
+	int ret = pthread_setaffinity_np(handle, sizeof(cpuset), &cpuset);
+	if (ret != 0)
+		LogErr("[ Jobs ] pthread_setaffinity_np[%u] failed, error %d", threadID, ret);
+
+	// Name the thread, 15 characters max
+	char name[16];
+	zpl_snprintf(name, sizeof(name), "%s_%u", namePrefix, threadID);
+	ret = pthread_setname_np(handle, name);
+	if (ret != 0)
+		LogErr("[ Jobs ] pthread_setname_np[%u] failed, error %d", threadID, ret);
+}
+#endif
 
-				while (zpl_atomic32_load(&JobsState.IsAlive))
-				{
-					Work(*threadIdx);
+internal BHEAP_COMPARE_FUNC(JobsTimerCompare)
+{
+	u64 due0 = *(const u64*)v0;
+	u64 due1 = *(const u64*)v1;
+	return (due0 < due1) ? -1 : (due0 > due1) ? 1 : 0;
+}
 
-					// Wait for more work
-					zpl_semaphore_wait(&thread->semaphore);
-				}
+// Must hold TimerLock
+internal void
+JobsTimerUpdateNext(JobScheduler* scheduler)
+{
+	BHeap* heap = &scheduler->TimerHeap;
+	u64 next = (heap->Count > 0) ? ((JobTimer*)heap->Items[0].User)->Due : UINT64_MAX;
+	zpl_atomic64_store(&scheduler->NextTimerDue, (i64)next);
+	zpl_atomic32_store(&scheduler->TimerCount, heap->Count);
+}
 
-				return (zpl_isize)0;
-			}, & threadIdx, sizeof(u32));
+// Milliseconds until the earliest timer is due, -1 without timers
+internal i32
+JobsTimerWaitMs(JobScheduler* scheduler)
+{
+	if (zpl_atomic32_load(&scheduler->TimerCount) == 0)
+		return -1;
 
-		// Platform thread
-#ifdef _WIN32
-		Win32_InitThread(thread->win32_handle, threadIdx);
-#elif defined(PLATFORM_LINUX)
-#define handle_error_en(en, msg) \
-               do { errno = en; perror(msg); } while (0)
+	u64 now = Platform::GetOSTime();
+	u64 due = (u64)zpl_atomic64_load(&scheduler->NextTimerDue);
+	if (due <= now)
+		return 0;
 
-		int ret;
-		cpu_set_t cpuset;
-		CPU_ZERO(&cpuset);
-		size_t cpusetsize = sizeof(cpuset);
+	u64 freq = Platform::GetOSFreq();
+	u64 waitMs = (due - now) / freq * 1000 + ((due - now) % freq * 1000 + freq - 1) / freq;
+	return (i32)Min(waitMs, (u64)INT32_MAX);
+}
 
-		CPU_SET(threadID, &cpuset);
-		ret = pthread_setaffinity_np(worker.native_handle(), cpusetsize, &cpuset);
-		if (ret != 0)
-			handle_error_en(ret, std::string(" pthread_setaffinity_np[" + std::to_string(threadID) + ']').c_str());
+// Queue the jobs of due timers
+internal void JobsPollTimers(JobScheduler* scheduler);
 
-		// Name the thread
-		std::string thread_name = "wi::job::" + std::to_string(threadID);
-		ret = pthread_setname_np(worker.native_handle(), thread_name.c_str());
-		if (ret != 0)
-			handle_error_en(ret, std::string(" pthread_setname_np[" + std::to_string(threadID) + ']').c_str());
-#undef handle_error_en
-#endif
-	}
+// Back on the free list with a new generation, so stale ids stop matching. Hold TimerLock.
+internal void JobsTimerFree(JobScheduler* scheduler, JobTimer* timer);
 
-	double timeEnd = GetTime() - startTime;
-	const char* infoStr = TextFormat(
-		"[ Jobs ] Initialized in [%.3fms]. Cores: %u, Theads: %d. Created %u threads."
-		, timeEnd * 1000.0
-		, JobsState.NumCores
-		, threadCount
-		, JobsState.NumThreads);
-	LogInfo(infoStr);
-	
-	SAssert(JobsState.NumCores > 0);
-	SAssert(JobsState.NumThreads > 0);
+// Index of the calling thread's mailbox and stats in the scheduler, -1 if it has none
+_FORCE_INLINE_ i32
+JobsGetThreadSlot(JobScheduler* scheduler)
+{
+	JobsThreadState* local = JobsGetLocalState();
+	if (local->Scheduler == scheduler)
+		return (i32)local->QueueIndex;
+	if (local == scheduler->MainThreadState)
+		return (i32)scheduler->NumThreads;
+	return -1;
 }
 
-u32 JobsGetThreadCount()
+_FORCE_INLINE_ JobMailbox*
+JobsGetMailbox(JobScheduler* scheduler)
 {
-	return JobsState.NumThreads;
+	i32 slot = JobsGetThreadSlot(scheduler);
+	return (slot >= 0) ? &scheduler->Mailboxes[slot] : nullptr;
 }
 
-void JobsExecute(JobHandle* handle, JobWorkFunc task, void* stack)
+_FORCE_INLINE_ JobWorkerStats*
+JobsGetThreadStats(JobScheduler* scheduler)
 {
-	SAssert(handle);
-	SAssert(task);
-
-	// Context state is updated:
-	zpl_atomic32_fetch_add(&handle->Counter, 1);
-
-	Job job;
-	job.handle = handle;
-	job.task = task;
-	job.stack = stack;
-	job.GroupId = 0;
-	job.groupJobOffset = 0;
-	job.groupJobEnd = 1;
-
-	zpl_i32 idx = zpl_atomic32_fetch_add(&JobsState.NextQueueIndex, 1) % JobsState.NumThreads;
-	JobsState.JobQueuePerThread[idx].PushBack(job);
-	zpl_semaphore_post(&JobsState.Threads.At(idx)->semaphore, 1);
+	i32 slot = JobsGetThreadSlot(scheduler);
+	return (slot >= 0) ? &scheduler->Stats[slot].Counters : nullptr;
 }
 
-void JobsDispatch(JobHandle* handle, u32 jobCount, u32 groupSize, JobWorkFunc task, void* stack)
+// Try every queue, starting with startingQueue, for a job on one lane
+internal bool
+JobsPopLane(JobScheduler* scheduler, u32 startingQueue, JobPriority priority, Job* job, JobWorkerStats* stats)
 {
-	SAssert(handle);
-	SAssert(task);
-	if (jobCount == 0 || groupSize == 0)
+	for (u32 i = 0; i < scheduler->NumThreads; ++i)
 	{
-		return;
+		u32 queueIdx = (startingQueue + i) % scheduler->NumThreads;
+		JobQueue* jobQueue = &scheduler->JobQueuePerThread[queueIdx];
+		if (stats && i > 0)
+			++stats->StealAttempts;
+		if (jobQueue->PopFront(*job, priority))
+		{
+			if (stats && i > 0)
+				++stats->Steals;
+			JOB_TRACE(JOB_TRACE_POP, job->handle, job->GroupId, priority, queueIdx, jobQueue->Count(priority));
+			return true;
+		}
 	}
+	return false;
+}
 
-	u32 groupCount = JobsDispatchGroupCount(jobCount, groupSize);
+// Take the next job for this thread. Higher lanes are drained first across all queues,
+// unless a lower lane was passed over JOB_PRIORITY_AGING_LIMIT times.
+internal bool
+JobsPopNext(JobScheduler* scheduler, u32 startingQueue, Job* job)
+{
+	JobMailbox* mailbox = JobsGetMailbox(scheduler);
+	if (mailbox && mailbox->Jobs.Dequeue(job))
+		return true;
 
-	// Context state is updated:
-	zpl_atomic32_fetch_add(&handle->Counter, groupCount);
+	u32* laneSkips = JobsGetLocalState()->LaneSkips;
+	JobWorkerStats* stats = JobsGetThreadStats(scheduler);
 
-	Job job;
-	job.handle = handle;
-	job.task = task;
-	job.stack = stack;
+	// Lowest lane has been waiting the longest
+	for (int lane = JOB_PRIORITY_MAX - 1; lane > JOB_PRIORITY_HIGH; --lane)
+	{
+		if (laneSkips[lane] >= JOB_PRIORITY_AGING_LIMIT)
+		{
+			laneSkips[lane] = 0;
+			if (JobsPopLane(scheduler, startingQueue, (JobPriority)lane, job, stats))
+				return true;
+		}
+	}
 
-	for (u32 GroupId = 0; GroupId < groupCount; ++GroupId)
+	for (int lane = JOB_PRIORITY_HIGH; lane < JOB_PRIORITY_MAX; ++lane)
 	{
-		// For each group, generate one real job:
+		if (JobsPopLane(scheduler, startingQueue, (JobPriority)lane, job, stats))
+		{
+			laneSkips[lane] = 0;
+			for (int lowerLane = lane + 1; lowerLane < JOB_PRIORITY_MAX; ++lowerLane)
+				++laneSkips[lowerLane];
+			return true;
+		}
+	}
+	return false;
+}
+
+internal bool
+JobsHasWork(JobScheduler* scheduler)
+{
+	if (JobsTimerWaitMs(scheduler) == 0)
+		return true;
+	JobMailbox* mailbox = JobsGetMailbox(scheduler);
+	if (mailbox && !mailbox->Jobs.IsEmpty())
+		return true;
+#if SCAL_JOBS_FIBERS
+	if (zpl_atomic32_load(&scheduler->ReadyFiberCount) > 0)
+		return true;
+#endif
+	for (u32 queueIdx = 0; queueIdx < scheduler->NumThreads; ++queueIdx)
+	{
+		for (int lane = JOB_PRIORITY_HIGH; lane < JOB_PRIORITY_MAX; ++lane)
+		{
+			if (!scheduler->JobQueuePerThread[queueIdx].IsEmpty((JobPriority)lane))
+				return true;
+		}
+	}
+	return false;
+}
+
+// Wake as many parked workers as there is new work, one syscall per batch
+internal void
+JobsWakeWorkers(JobScheduler* scheduler, u32 jobCount)
+{
+	// Publish the queued jobs before reading SleepingCount, JobsPark does the opposite
+	zpl_mfence();
+	i32 sleeping = zpl_atomic32_load(&scheduler->SleepingCount);
+	if (sleeping > 0)
+	{
+		zpl_atomic32_fetch_add(&scheduler->WakeEpoch, 1);
+		FutexWake(&scheduler->WakeEpoch, Min((i32)jobCount, sleeping));
+	}
+}
+
+// Spin briefly, then sleep until JobsWakeWorkers, the next timer or shutdown
+internal void
+JobsPark(JobScheduler* scheduler)
+{
+	i32 slot = JobsGetThreadSlot(scheduler);
+	JobWorkerStats* stats = (slot >= 0) ? &scheduler->Stats[slot].Counters : nullptr;
+	u64 idleStart = Platform::GetCPUTime();
+	if (stats)
+		scheduler->Stats[slot].IdleSince = idleStart;
+
+	bool hasWork = false;
+	for (u32 spin = 0; spin < JOB_PARK_SPIN_COUNT && !hasWork; ++spin)
+	{
+		hasWork = JobsHasWork(scheduler);
+		if (!hasWork)
+			zpl_yield();
+	}
+
+	if (!hasWork)
+	{
+		i32 epoch = zpl_atomic32_load(&scheduler->WakeEpoch);
+		zpl_atomic32_fetch_add(&scheduler->SleepingCount, 1);
+		if (!JobsHasWork(scheduler) && zpl_atomic32_load(&scheduler->IsAlive))
+		{
+			JOB_TRACE(JOB_TRACE_PARK_BEGIN, nullptr, 0, 0);
+			FutexWait(&scheduler->WakeEpoch, epoch, JobsTimerWaitMs(scheduler));
+			JOB_TRACE(JOB_TRACE_PARK_END, nullptr, 0, 0);
+			if (stats)
+				++stats->Parks;
+		}
+		zpl_atomic32_fetch_add(&scheduler->SleepingCount, -1);
+	}
+
+	if (stats)
+	{
+		stats->IdleTicks += Platform::GetCPUTime() - idleStart;
+		scheduler->Stats[slot].IdleSince = 0;
+	}
+}
+
+// Count finished groups of a handle, fibers waiting on it are resumed when it reaches zero
+internal void JobHandleRelease(JobHandle* handle, i32 count);
+
+// Scratch arena of whatever runs the job, the current fiber or else the thread. Code that
+// dispatches can take its temporaries from it too, jobs run while waiting snapshot above them.
+internal Arena*
+JobsGetScratch()
+{
+	JobsThreadState* local = JobsGetLocalState();
+	Arena* scratch = &local->Scratch;
+#if SCAL_JOBS_FIBERS
+	if (local->CurrentFiber && local->CurrentFiber != &local->ThreadFiber)
+		scratch = &local->CurrentFiber->Scratch;
+#endif
+	if (!scratch->Memory)
+		*scratch = ArenaCreate(JOB_SCRATCH_RESERVE_SIZE, JOB_SCRATCH_COMMIT_SIZE);
+	return scratch;
+}
+
+internal void
+JobsRunGroup(const Job& job, u32 groupId, u32 groupJobOffset, u32 groupJobEnd)
+{
+	JOB_TRACE(JOB_TRACE_JOB_BEGIN, job.handle, groupId, job.priority);
+
+	JobWorkerStats* stats = JobsGetThreadStats(job.scheduler);
+	if (stats)
+		++stats->JobsExecuted;
+
+	// Jobs this one runs while it waits snapshot above this point, so rollbacks stay in order
+	Arena* scratch = JobsGetScratch();
+	ArenaSnapshot scratchSnapshot = ArenaSnapshotBegin(scratch);
+
+	if (job.rangeTask)
+	{
+		JobRangeArgs args;
+		args.StackMemory = job.stack;
+		args.Handle = job.handle;
+		args.Scratch = scratch;
+		args.Begin = groupJobOffset;
+		args.End = groupJobEnd;
+		args.GroupId = groupId;
+		job.rangeTask(&args);
+	}
+	else
+	{
+		SAssert(job.task || job.closure);
+
+		void* closure = (void*)job.closureStorage;
+		if (job.closureHeap)
+			SMemCopy(&closure, job.closureStorage, sizeof(closure));
+
+		for (u32 j = groupJobOffset; j < groupJobEnd; ++j)
+		{
+			JobArgs args;
+			args.GroupId = groupId;
+			args.StackMemory = job.stack;
+			args.Handle = job.handle;
+			args.Scratch = scratch;
+			args.JobIndex = j;
+			args.GroupIndex = j - groupJobOffset;
+			args.IsFirstJobInGroup = (j == groupJobOffset);
+			args.IsLastJobInGroup = (j == groupJobEnd - 1);
+			if (job.closure)
+				job.closure(closure, &args);
+			else
+				job.task(&args);
+		}
+	}
+
+	ArenaSnapshotEnd(scratchSnapshot);
+
+	JOB_TRACE(JOB_TRACE_JOB_END, job.handle, groupId, job.priority);
+}
+
+// Past its deadline, only reads the clock when the handle has one
+_FORCE_INLINE_ bool
+JobsIsLate(const JobHandle* handle)
+{
+	return handle->Deadline && Platform::GetOSTime() > handle->Deadline;
+}
+
+// Cancelled, or late with JOB_DEADLINE_DROP
+_FORCE_INLINE_ bool
+JobsIsDropped(const JobHandle* handle)
+{
+	return JobHandleIsCancelled(handle) || (handle->DeadlinePolicy == JOB_DEADLINE_DROP && JobsIsLate(handle));
+}
+
+// Run a JobsDispatchAuto range chunk by chunk. Before each chunk the upper half of what is
+// left is handed back to the queues if this thread has nothing queued for others to steal.
+internal void
+JobsRunSplittable(const Job& job)
+{
+	JobScheduler* scheduler = job.scheduler;
+	u32 grain = job.splitGrain;
+	u32 begin = job.groupJobOffset;
+	u32 end = job.groupJobEnd;
+	while (begin < end && !JobsIsDropped(job.handle))
+	{
+		u32 queueIdx = JobsGetLocalState()->QueueIndex % scheduler->NumThreads;
+		JobQueue* jobQueue = &scheduler->JobQueuePerThread[queueIdx];
+		if (end - begin >= 2 * grain && jobQueue->IsEmpty(job.priority))
+		{
+			u32 mid = begin + ((end - begin) / grain / 2) * grain;
+
+			Job half = job;
+			half.groupJobOffset = mid;
+			half.groupJobEnd = end;
+			zpl_atomic32_fetch_add(&job.handle->Counter, 1);
+			if (jobQueue->PushBack(half, job.priority))
+			{
+				JobsWakeWorkers(scheduler, 1);
+				end = mid;
+				continue;
+			}
+
+			// Queue filled up in the meantime, keep the range
+			zpl_atomic32_fetch_add(&job.handle->Counter, -1);
+			zpl_atomic64_fetch_add(&scheduler->Overflows, 1);
+		}
+
+		u32 chunkEnd = Min(begin + grain, end);
+		JobsRunGroup(job, begin / grain, begin, chunkEnd);
+		begin = chunkEnd;
+	}
+}
+
+internal void JobsSubmit(const Job& job);
+
+// Run every job in the group, unless the handle was cancelled or its deadline passed
+internal void
+JobsRunJob(const Job& job)
+{
+	const JobHandle* handle = job.handle;
+	if (handle->Deadline && handle->DeadlinePolicy == JOB_DEADLINE_DEPRIORITIZE
+		&& job.priority != JOB_PRIORITY_BACKGROUND && JobsIsLate(handle))
+	{
+		// Late, everything else goes first. Still counted, so nothing to release.
+		Job late = job;
+		late.priority = JOB_PRIORITY_BACKGROUND;
+		JobsSubmit(late);
+		return;
+	}
+
+	// Dropped groups are released below like the ones that ran
+	if (!JobsIsDropped(handle))
+	{
+		if (job.splitGrain)
+			JobsRunSplittable(job);
+		else
+			JobsRunGroup(job, job.GroupId, job.groupJobOffset, job.groupJobEnd);
+	}
+
+	if (job.closureHeap && zpl_atomic32_fetch_add(&job.closureHeap->Refs, -1) == 1)
+		job.closureHeap->Destroy(job.closureHeap);
+
+	JobHandleRelease(job.handle, 1);
+}
+
+// A worker an elastic scheduler parked sleeps here until it is needed again or shutdown,
+// only jobs posted to its mailbox still run
+internal void
+JobsParkReserve(JobScheduler* scheduler, u32 threadIdx)
+{
+	i32 epoch = zpl_atomic32_load(&scheduler->ReserveEpoch);
+	if (threadIdx < (u32)zpl_atomic32_load(&scheduler->ActiveThreads) || !zpl_atomic32_load(&scheduler->IsAlive))
+		return;
+
+	JobMailbox* mailbox = &scheduler->Mailboxes[threadIdx];
+	Job job;
+	if (mailbox->Jobs.Dequeue(&job))
+	{
+		JobsRunJob(job);
+		return;
+	}
+
+	// Idle like JobsPark, or reserve workers would count as always busy
+	i32 slot = JobsGetThreadSlot(scheduler);
+	JobStatsSlot* statsSlot = (slot >= 0) ? &scheduler->Stats[slot] : nullptr;
+	u64 idleStart = Platform::GetCPUTime();
+	if (statsSlot)
+	{
+		statsSlot->IsInReserve = true;
+		statsSlot->IdleSince = idleStart;
+	}
+
+	JOB_TRACE(JOB_TRACE_PARK_BEGIN, nullptr, 0, 0);
+	FutexWait(&scheduler->ReserveEpoch, epoch);
+	JOB_TRACE(JOB_TRACE_PARK_END, nullptr, 0, 0);
+
+	if (statsSlot)
+	{
+		u64 idle = Platform::GetCPUTime() - idleStart;
+		++statsSlot->Counters.Parks;
+		statsSlot->Counters.IdleTicks += idle;
+		statsSlot->ReserveTicks += idle;
+		statsSlot->IdleSince = 0;
+		statsSlot->IsInReserve = false;
+	}
+}
+
+//	Start working on a job queue
+//	After the job queue is finished, it can switch to an other queue and steal jobs from there
+internal void 
+Work(JobScheduler* scheduler, u32 startingQueue)
+{
+	Job job;
+	JobsPollTimers(scheduler);
+	while (JobsPopNext(scheduler, startingQueue, &job))
+	{
+		JobsRunJob(job);
+		JobsPollTimers(scheduler);
+	}
+}
+
+#if SCAL_JOBS_FIBERS
+
+internal void JobsFiberLoop();
+internal void JobsFiberAfterSwitch();
+
+#ifdef _WIN32
+internal VOID CALLBACK
+JobsFiberEntry(PVOID)
+#else
+internal void
+JobsFiberEntry()
+#endif
+{
+	JobsFiberAfterSwitch();
+	JobsFiberLoop();
+}
+
+internal void
+JobsFiberCreate(Arena* arena, JobFiber* fiber)
+{
+#ifdef _WIN32
+	fiber->Handle = CreateFiber(JOB_FIBER_STACK_SIZE, JobsFiberEntry, fiber);
+	SAssert(fiber->Handle);
+#else
+	fiber->Stack = ArenaPush(arena, JOB_FIBER_STACK_SIZE);
+	getcontext(&fiber->Context);
+	fiber->Context.uc_stack.ss_sp = fiber->Stack;
+	fiber->Context.uc_stack.ss_size = JOB_FIBER_STACK_SIZE;
+	fiber->Context.uc_link = nullptr;
+	makecontext(&fiber->Context, JobsFiberEntry, 0);
+#endif
+}
+
+// Returns null when every fiber is in use
+internal JobFiber*
+JobsFiberAcquire(JobScheduler* scheduler)
+{
+	zpl_mutex_lock(&scheduler->FiberLock);
+	JobFiber* fiber = scheduler->FreeFibers;
+	SLStackPop(scheduler->FreeFibers, Next);
+	zpl_mutex_unlock(&scheduler->FiberLock);
+	return fiber;
+}
+
+internal JobFiber*
+JobsFiberPopReady(JobScheduler* scheduler)
+{
+	if (zpl_atomic32_load(&scheduler->ReadyFiberCount) == 0)
+		return nullptr;
+
+	zpl_mutex_lock(&scheduler->FiberLock);
+	JobFiber* fiber = scheduler->ReadyFibersFirst;
+	if (fiber)
+	{
+		SLQueuePop(scheduler->ReadyFibersFirst, scheduler->ReadyFibersLast);
+		zpl_atomic32_fetch_add(&scheduler->ReadyFiberCount, -1);
+	}
+	zpl_mutex_unlock(&scheduler->FiberLock);
+	return fiber;
+}
+
+// Must hold FiberLock
+internal void
+JobsFiberPushReady(JobScheduler* scheduler, JobFiber* fiber)
+{
+	fiber->WaitingOn = nullptr;
+	SLQueuePush(scheduler->ReadyFibersFirst, scheduler->ReadyFibersLast, fiber, Next);
+	zpl_atomic32_fetch_add(&scheduler->ReadyFiberCount, 1);
+}
+
+// Finish what the previous fiber asked for, it is safe now that we left its stack
+internal void
+JobsFiberAfterSwitch()
+{
+	JobsThreadState* local = JobsGetLocalState();
+	JobScheduler* scheduler = local->Scheduler;
+	JobFiber* previous = local->PreviousFiber;
+	JobFiberAction action = local->PreviousAction;
+	local->PreviousFiber = nullptr;
+	local->PreviousAction = JOB_FIBER_ACTION_NONE;
+
+	if (action == JOB_FIBER_ACTION_FREE)
+	{
+		zpl_mutex_lock(&scheduler->FiberLock);
+		SLStackPush(scheduler->FreeFibers, previous, Next);
+		zpl_mutex_unlock(&scheduler->FiberLock);
+	}
+	else if (action == JOB_FIBER_ACTION_WAIT)
+	{
+		zpl_mutex_lock(&scheduler->FiberLock);
+		// Counted before checking the handle, JobHandleRelease checks in the opposite order
+		zpl_atomic32_fetch_add(&scheduler->WaitingFiberCount, 1);
+		if (JobHandleIsBusy(previous->WaitingOn))
+		{
+			SLStackPush(scheduler->WaitingFibers, previous, Next);
+		}
+		else
+		{
+			zpl_atomic32_fetch_add(&scheduler->WaitingFiberCount, -1);
+			JobsFiberPushReady(scheduler, previous);
+		}
+		zpl_mutex_unlock(&scheduler->FiberLock);
+	}
+}
+
+internal void
+JobsFiberSwitch(JobFiber* to, JobFiberAction action)
+{
+	SAssert(to);
+	JobsThreadState* local = JobsGetLocalState();
+	JobFiber* from = local->CurrentFiber;
+	local->PreviousFiber = from;
+	local->PreviousAction = action;
+	local->CurrentFiber = to;
+#ifdef _WIN32
+	SwitchToFiber(to->Handle);
+#else
+	swapcontext(&from->Context, &to->Context);
+#endif
+	JobsFiberAfterSwitch();
+}
+
+// Jobs suspended in JobHandleWait, parked or resumed and not picked up yet. They must finish
+// before the workers leave, or their handles never do.
+_FORCE_INLINE_ bool
+JobsHasSuspendedFibers(JobScheduler* scheduler)
+{
+	return zpl_atomic32_load(&scheduler->ReadyFiberCount) > 0
+		|| zpl_atomic32_load(&scheduler->WaitingFiberCount) > 0;
+}
+
+// Move every fiber waiting on handle to the ready list and wake a worker to pick them up
+internal void
+JobsFiberWakeWaiters(JobScheduler* scheduler, const JobHandle* handle)
+{
+	int readied = 0;
+	zpl_mutex_lock(&scheduler->FiberLock);
+	JobFiber** link = &scheduler->WaitingFibers;
+	while (*link)
+	{
+		JobFiber* fiber = *link;
+		if (fiber->WaitingOn == handle)
+		{
+			*link = fiber->Next;
+			zpl_atomic32_fetch_add(&scheduler->WaitingFiberCount, -1);
+			JobsFiberPushReady(scheduler, fiber);
+			++readied;
+		}
+		else
+		{
+			link = &fiber->Next;
+		}
+	}
+	zpl_mutex_unlock(&scheduler->FiberLock);
+
+	if (readied > 0)
+	{
+		JobsWakeWorkers(scheduler, readied);
+	}
+}
+
+// Worker loop every fiber runs, resumed fibers take priority over new jobs
+internal void
+JobsFiberLoop()
+{
+	for (;;)
+	{
+		JobsThreadState* local = JobsGetLocalState();
+		JobScheduler* scheduler = local->Scheduler;
+		bool isAlive = zpl_atomic32_load(&scheduler->IsAlive) != 0;
+		if (!isAlive && !JobsHasSuspendedFibers(scheduler))
+		{
+			JobsFiberSwitch(&local->ThreadFiber, JOB_FIBER_ACTION_FREE);
+			continue;
+		}
+
+		if (isAlive && local->QueueIndex >= (u32)zpl_atomic32_load(&scheduler->ActiveThreads))
+		{
+			JobsParkReserve(scheduler, local->QueueIndex);
+			continue;
+		}
+
+		JobFiber* ready = JobsFiberPopReady(scheduler);
+		if (ready)
+		{
+			JobsFiberSwitch(ready, JOB_FIBER_ACTION_FREE);
+			continue;
+		}
+
+		JobsPollTimers(scheduler);
+
+		Job job;
+		if (JobsPopNext(scheduler, local->QueueIndex, &job))
+		{
+			JobsRunJob(job);
+			continue;
+		}
+
+		// Wait for more work, on shutdown only until the suspended fibers are resumed
+		if (isAlive)
+			JobsPark(scheduler);
+		else
+			zpl_yield_thread();
+	}
+}
+
+// Turn the worker thread into a fiber and run the loop until shutdown
+internal void
+JobsFiberRunWorker()
+{
+	JobsThreadState* local = JobsGetLocalState();
+#ifdef _WIN32
+	local->ThreadFiber.Handle = ConvertThreadToFiber(nullptr);
+	SAssert(local->ThreadFiber.Handle);
+#endif
+	local->CurrentFiber = &local->ThreadFiber;
+
+	JobFiber* fiber = JobsFiberAcquire(local->Scheduler);
+	SAssertMsg(fiber, "No free fiber to start a worker");
+	if (fiber)
+	{
+		JobsFiberSwitch(fiber, JOB_FIBER_ACTION_NONE);
+	}
+
+	local = JobsGetLocalState();
+	local->CurrentFiber = nullptr;
+#ifdef _WIN32
+	ConvertFiberToThread();
+#endif
+}
+
+#endif // SCAL_JOBS_FIBERS
+
+#if SCAL_JOBS_FIBERS
+// Schedulers with workers. A job can wait on a handle released by another scheduler's jobs,
+// so its fiber is looked for in all of them.
+internal zpl_atomic_ptr JobsSchedulers[JOB_SCHEDULER_MAX];
+#endif
+
+internal void
+JobHandleRelease(JobHandle* handle, i32 count)
+{
+	SAssert(handle);
+	zpl_i32 previous = zpl_atomic32_fetch_add(&handle->Counter, -count);
+	SAssert(previous >= count);
+	if (previous != count)
+		return;
+
+#if SCAL_JOBS_FIBERS
+	// Last reference, fibers waiting on it can resume
+	for (u32 schedulerIdx = 0; schedulerIdx < JOB_SCHEDULER_MAX; ++schedulerIdx)
+	{
+		JobScheduler* scheduler = (JobScheduler*)zpl_atomic_ptr_load(&JobsSchedulers[schedulerIdx]);
+		if (scheduler && zpl_atomic32_load(&scheduler->WaitingFiberCount) > 0)
+			JobsFiberWakeWaiters(scheduler, handle);
+	}
+#endif
+}
+
+void JobsInitialize(Arena* arena, u32 maxThreadCount)
+{
+	JobSchedulerDesc desc = {};
+	desc.MaxThreadCount = maxThreadCount;
+	JobsInitialize(&JobsState, arena, desc);
+}
+
+void JobsInitialize(JobScheduler* scheduler, Arena* arena, const JobSchedulerDesc& desc)
+{
+	SAssert(scheduler);
+	if (scheduler->Threads.Count > 0)
+	{
+		SCAL_ERROR("Job internal state already initialized");
+		return;
+	}
+
+	SAssert(desc.MaxThreadCount > 0);
+	SAssert(!desc.Cpus || desc.CpuCount > 0);
+
+	float startTime = GetTime();
+
+	u32 maxThreadCount = Max(1u, desc.MaxThreadCount);
+	if (desc.Name)
+		scheduler->Name = desc.Name;
+
+#ifdef PLATFORM_LINUX
+	// Too large for the stack, only needed during initialization
+	ArenaSnapshot topologySnapshot = ArenaSnapshotBegin(GetScratch());
+	LinuxCpuTopology* topology = ArenaPushStruct(topologySnapshot.Arena, LinuxCpuTopology);
+	Linux_QueryTopology(topology);
+
+	u32 coreCount = topology->PhysicalCoreCount;
+	u32 threadCount = topology->CpuCount;
+	if (topology->QuotaCpus > 0)
+		threadCount = Min(threadCount, topology->QuotaCpus);
+
+	LogInfo("[ Jobs ] Linux topology: %u cpus allowed, %u physical cores, %u L3 domains, cgroup quota %u cpus."
+		, topology->CpuCount
+		, topology->PhysicalCoreCount
+		, topology->L3Count
+		, topology->QuotaCpus);
+#else
+	zpl_affinity affinity;
+	zpl_affinity_init(&affinity);
+
+	u32 coreCount = (u32)affinity.core_count;
+	u32 threadCount = (u32)affinity.thread_count;
+
+	zpl_affinity_destroy(&affinity);
+#endif
+
+	if (coreCount == 0)
+	{
+		SCAL_ERROR("coreCount == 0");
+	}
+
+	scheduler->NumCores = coreCount;
+	if (desc.Cpus)
+	{
+		// The caller picked the cores, at most one worker each
+		scheduler->NumThreads = Min(maxThreadCount, desc.CpuCount);
+	}
+	else
+	{
+		// In a local, Min/Max do not parenthesize their arguments
+#ifdef PLATFORM_LINUX
+		// -1 for main thread, the allowed set and quota already leave room for the rest of the system
+		u32 wantedThreads = (threadCount > 1) ? threadCount - 1 : 1;
+#else
+		// -2, 1 for main thread, 1 so pc can do other things
+		u32 wantedThreads = (threadCount > 2) ? threadCount - 2 : 1;
+#endif
+		scheduler->NumThreads = ClampValue(wantedThreads, 1u, maxThreadCount);
+	}
+
+	// Started again after JobsShutdown
+	zpl_atomic32_store(&scheduler->IsAlive, 1);
+	zpl_atomic32_store(&scheduler->ActiveThreads, (i32)scheduler->NumThreads);
+	scheduler->ElasticTimer = 0;
+
+	scheduler->JobQueuePerThread = ArenaPushArrayZero(arena, JobQueue, scheduler->NumThreads);
+
+	scheduler->Mailboxes = ArenaPushArrayZero(arena, JobMailbox, scheduler->NumThreads + 1);
+	for (u32 mailboxIdx = 0; mailboxIdx <= scheduler->NumThreads; ++mailboxIdx)
+	{
+		zpl_mutex_init(&scheduler->Mailboxes[mailboxIdx].Lock);
+	}
+	scheduler->MainThreadState = JobsGetLocalState();
+
+	scheduler->Stats = ArenaPushArrayZero(arena, JobStatsSlot, scheduler->NumThreads + 1);
+	JobsResetStats(scheduler);
+
+	scheduler->Timers = ArenaPushArrayZero(arena, JobTimer, JOB_TIMER_COUNT);
+	scheduler->FreeTimers = nullptr;
+	for (int timerIdx = JOB_TIMER_COUNT - 1; timerIdx >= 0; --timerIdx)
+	{
+		SLStackPush(scheduler->FreeTimers, &scheduler->Timers[timerIdx], Next);
+	}
+	scheduler->TimerHeap.Init(arena, JOB_TIMER_COUNT, JobsTimerCompare);
+	JobsTimerUpdateNext(scheduler);
+
+#if SCAL_JOBS_TRACE
+	scheduler->TraceBuffers = ArenaPushArrayZero(arena, JobTraceBuffer, scheduler->NumThreads + 1);
+	for (u32 bufferIdx = 0; bufferIdx <= scheduler->NumThreads; ++bufferIdx)
+	{
+		scheduler->TraceBuffers[bufferIdx].Events = ArenaPushArray(arena, JobTraceEvent, JOB_TRACE_CAPACITY);
+		scheduler->TraceBuffers[bufferIdx].Scheduler = scheduler;
+	}
+	// Traced with the first scheduler it starts
+	if (!JobsGetLocalState()->TraceBuffer)
+		JobsGetLocalState()->TraceBuffer = &scheduler->TraceBuffers[scheduler->NumThreads];
+#endif
+
+#if SCAL_JOBS_FIBERS
+	JobFiber* fibers = ArenaPushArrayZero(arena, JobFiber, JOB_FIBER_COUNT);
+	for (u32 fiberIdx = 0; fiberIdx < JOB_FIBER_COUNT; ++fiberIdx)
+	{
+		JobsFiberCreate(arena, &fibers[fiberIdx]);
+		SLStackPush(scheduler->FreeFibers, &fibers[fiberIdx], Next);
+	}
+
+	bool isRegistered = false;
+	for (u32 schedulerIdx = 0; schedulerIdx < JOB_SCHEDULER_MAX && !isRegistered; ++schedulerIdx)
+	{
+		isRegistered = !zpl_atomic_ptr_compare_exchange(&JobsSchedulers[schedulerIdx], nullptr, scheduler);
+	}
+	SAssertMsg(isRegistered, "More than JOB_SCHEDULER_MAX schedulers, fibers waiting across them may not resume");
+#endif
+	scheduler->Threads.Resize(arena, scheduler->NumThreads);
+	scheduler->Threads.PushMany(scheduler->NumThreads);
+	SAssert(scheduler->Threads.Memory);
+
+	for (u32 threadIdx = 0; threadIdx < scheduler->NumThreads; ++threadIdx)
+	{
+		zpl_thread* thread = scheduler->Threads.At(threadIdx);
+		zpl_thread_init(thread);
+
+		thread->user_index = threadIdx;
+
+		zpl_thread_start(thread, [](zpl_thread* thread)
+			{
+				JobScheduler* scheduler = (JobScheduler*)thread->user_data;
+				u32 threadIdx = (u32)thread->user_index;
+				JobsGetLocalState()->Scheduler = scheduler;
+				JobsGetLocalState()->QueueIndex = threadIdx;
+#if SCAL_JOBS_TRACE
+				JobsGetLocalState()->TraceBuffer = &scheduler->TraceBuffers[threadIdx];
+#endif
+
+#if SCAL_JOBS_FIBERS
+				JobsFiberRunWorker();
+#else
+				while (zpl_atomic32_load(&scheduler->IsAlive))
+				{
+					if (threadIdx >= (u32)zpl_atomic32_load(&scheduler->ActiveThreads))
+					{
+						JobsParkReserve(scheduler, threadIdx);
+						continue;
+					}
+
+					Work(scheduler, threadIdx);
+
+					// Wait for more work
+					JobsPark(scheduler);
+				}
+#endif
+
+				return (zpl_isize)0;
+			}, scheduler);
+
+		// Platform thread
+#ifdef _WIN32
+		u32 cpu = desc.Cpus ? desc.Cpus[threadIdx % desc.CpuCount] : threadIdx;
+		Win32_InitThread(thread->win32_handle, threadIdx, cpu, scheduler->Name);
+#elif defined(PLATFORM_LINUX)
+		if (desc.Cpus)
+		{
+			Linux_InitThread(thread->posix_handle, threadIdx, (int)desc.Cpus[threadIdx % desc.CpuCount], scheduler->Name);
+		}
+		else if (topology->CpuCount > 0)
+		{
+			// Workers start after the first placement slot, which is left to the main thread
+			int cpu = topology->Cpus[(threadIdx + 1) % topology->CpuCount].Cpu;
+			Linux_InitThread(thread->posix_handle, threadIdx, cpu, scheduler->Name);
+		}
+#endif
+	}
+
+#ifdef PLATFORM_LINUX
+	ArenaSnapshotEnd(topologySnapshot);
+#endif
+
+	double timeEnd = GetTime() - startTime;
+	const char* infoStr = TextFormat(
+		"[ Jobs ] %s initialized in [%.3fms]. Cores: %u, Theads: %d. Created %u threads."
+		, scheduler->Name
+		, timeEnd * 1000.0
+		, scheduler->NumCores
+		, threadCount
+		, scheduler->NumThreads);
+	LogInfo(infoStr);
+	
+	SAssert(scheduler->NumCores > 0);
+	SAssert(scheduler->NumThreads > 0);
+}
+
+void JobsShutdown(JobScheduler* scheduler)
+{
+	SAssert(scheduler);
+	if (scheduler->Threads.Count == 0)
+	{
+		return;
+	}
+
+	zpl_atomic32_store(&scheduler->IsAlive, 0); // indicate that new jobs cannot be started from this point
+
+	zpl_atomic32_fetch_add(&scheduler->WakeEpoch, 1);
+	FutexWakeAll(&scheduler->WakeEpoch);
+	zpl_atomic32_fetch_add(&scheduler->ReserveEpoch, 1);
+	FutexWakeAll(&scheduler->ReserveEpoch);
+
+#if SCAL_JOBS_FIBERS
+	// Workers stay until suspended jobs finish, what they wait on may be queued for this thread
+	while (JobsHasSuspendedFibers(scheduler))
+	{
+		Job job;
+		if (JobsPopNext(scheduler, 0, &job))
+		{
+			JobsRunJob(job);
+			continue;
+		}
+		JobsPollTimers(scheduler);
+		zpl_yield_thread();
+	}
+#endif
+
+	for (u32 i = 0; i < scheduler->Threads.Count; ++i)
+	{
+		zpl_thread_join(scheduler->Threads.At(i));
+		zpl_thread_destroy(scheduler->Threads.At(i));
+	}
+	scheduler->Threads.RemoveMany(scheduler->Threads.Count);
+
+	// Jobs still queued run here, so nothing waits on them forever
+	Work(scheduler, 0);
+	for (u32 mailboxIdx = 0; mailboxIdx <= scheduler->NumThreads; ++mailboxIdx)
+	{
+		Job job;
+		while (scheduler->Mailboxes[mailboxIdx].Jobs.Dequeue(&job))
+			JobsRunJob(job);
+	}
+
+	// Timers that have not fired are dropped as if cancelled, one-shot ones still hold
+	// their handle and let go of it here
+	JobHandle* pendingHandles[JOB_TIMER_COUNT];
+	u32 pendingCount = 0;
+	zpl_mutex_lock(&scheduler->TimerLock);
+	BHeap* timerHeap = &scheduler->TimerHeap;
+	while (timerHeap->Count > 0)
+	{
+		JobTimer* timer = (JobTimer*)timerHeap->Items[0].User;
+		timerHeap->PopMin();
+		if (timer->Task && !timer->Period)
+			pendingHandles[pendingCount++] = timer->Handle;
+		JobsTimerFree(scheduler, timer);
+	}
+	JobsTimerUpdateNext(scheduler);
+	zpl_mutex_unlock(&scheduler->TimerLock);
+
+	for (u32 pendingIdx = 0; pendingIdx < pendingCount; ++pendingIdx)
+		JobHandleRelease(pendingHandles[pendingIdx], 1);
+
+#if SCAL_JOBS_FIBERS
+	for (u32 schedulerIdx = 0; schedulerIdx < JOB_SCHEDULER_MAX; ++schedulerIdx)
+	{
+		zpl_atomic_ptr_compare_exchange(&JobsSchedulers[schedulerIdx], scheduler, nullptr);
+	}
+#endif
+
+	LogInfo("[ Jobs ] %s threads shutdown!", scheduler->Name);
+}
+
+JobScheduler::~JobScheduler()
+{
+	JobsShutdown(this);
+}
+
+u32 JobsGetThreadCount()
+{
+	return JobsState.NumThreads;
+}
+
+u32 JobsGetThreadCount(JobScheduler* scheduler)
+{
+	SAssert(scheduler);
+	return scheduler->NumThreads;
+}
+
+JobScheduler* JobsGetCurrentScheduler()
+{
+	JobScheduler* scheduler = JobsGetLocalState()->Scheduler;
+	return scheduler ? scheduler : &JobsState;
+}
+
+// Queue a job on the next queue round-robin, callers wake workers once per batch.
+// If that queue is full the others are tried, and if every queue is full the job
+// runs right here so nothing is dropped and the handle still reaches zero.
+internal void
+JobsSubmit(const Job& job)
+{
+	JobScheduler* scheduler = job.scheduler;
+	// Parked workers' queues are only used once the active ones are full, the others steal from them
+	zpl_i32 idx = zpl_atomic32_fetch_add(&scheduler->NextQueueIndex, 1) % zpl_atomic32_load(&scheduler->ActiveThreads);
+	for (u32 i = 0; i < scheduler->NumThreads; ++i)
+	{
+		JobQueue* jobQueue = &scheduler->JobQueuePerThread[(idx + i) % scheduler->NumThreads];
+		if (jobQueue->PushBack(job, job.priority))
+		{
+			i32 depth = jobQueue->Count(job.priority);
+			if (depth > zpl_atomic32_load(&jobQueue->HighWater))
+				zpl_atomic32_store(&jobQueue->HighWater, depth);
+			return;
+		}
+		zpl_atomic64_fetch_add(&scheduler->Overflows, 1);
+	}
+
+	// Workers may still be asleep on jobs queued earlier in this batch
+	JobsWakeWorkers(scheduler, scheduler->NumThreads);
+	zpl_atomic64_fetch_add(&scheduler->InlineRuns, 1);
+	JobsRunJob(job);
+}
+
+// One job per group, job holds the task, stack, handle and priority
+internal void
+JobsSubmitGroups(Job job, u32 jobCount, u32 groupSize)
+{
+	SAssert(job.handle);
+	SAssert(job.scheduler);
+	SAssert(job.task || job.rangeTask || job.closure);
+	if (jobCount == 0 || groupSize == 0)
+	{
+		return;
+	}
+
+	u32 groupCount = JobsDispatchGroupCount(jobCount, groupSize);
+
+	// Context state is updated:
+	zpl_atomic32_fetch_add(&job.handle->Counter, groupCount);
+
+	job.splitGrain = 0;
+	for (u32 GroupId = 0; GroupId < groupCount; ++GroupId)
+	{
+		// For each group, generate one real job:
 		job.GroupId = GroupId;
 		job.groupJobOffset = GroupId * groupSize;
 		job.groupJobEnd = Min(job.groupJobOffset + groupSize, jobCount);
-		
-		zpl_i32 idx = zpl_atomic32_fetch_add(&JobsState.NextQueueIndex, 1) % JobsState.NumThreads;
-		JobsState.JobQueuePerThread[idx].PushBack(job);
-		zpl_semaphore_post(&JobsState.Threads.At(idx)->semaphore, 1);
+		JobsSubmit(job);
+	}
+	JobsWakeWorkers(job.scheduler, groupCount);
+}
+
+// One job for the whole range, split up while it runs
+internal void
+JobsSubmitSplittable(Job job, u32 jobCount)
+{
+	SAssert(job.handle);
+	SAssert(job.scheduler);
+	SAssert(job.task || job.rangeTask);
+	if (jobCount == 0)
+	{
+		return;
+	}
+
+	zpl_atomic32_fetch_add(&job.handle->Counter, 1);
+
+	job.GroupId = 0;
+	job.groupJobOffset = 0;
+	job.groupJobEnd = jobCount;
+	job.splitGrain = Max(1u, jobCount / (job.scheduler->NumThreads * JOB_AUTO_CHUNKS_PER_THREAD));
+	JobsSubmit(job);
+	JobsWakeWorkers(job.scheduler, 1);
+}
+
+// Must hold TimerLock
+internal void
+JobsTimerFree(JobScheduler* scheduler, JobTimer* timer)
+{
+	timer->Task = nullptr;
+	++timer->Generation;
+	SLStackPush(scheduler->FreeTimers, timer, Next);
+}
+
+internal void
+JobsPollTimers(JobScheduler* scheduler)
+{
+	if (zpl_atomic32_load(&scheduler->TimerCount) == 0)
+		return;
+
+	u64 now = Platform::GetOSTime();
+	if (now < (u64)zpl_atomic64_load(&scheduler->NextTimerDue))
+		return;
+
+	// One thread fires them, the others carry on with their jobs
+	if (!zpl_mutex_try_lock(&scheduler->TimerLock))
+		return;
+
+	Job dueJobs[JOB_TIMER_FIRE_BATCH];
+	u32 dueCount = 0;
+	BHeap* heap = &scheduler->TimerHeap;
+	while (heap->Count > 0 && dueCount < JOB_TIMER_FIRE_BATCH)
+	{
+		JobTimer* timer = (JobTimer*)heap->Items[0].User;
+		if (timer->Due > now)
+			break;
+
+		heap->PopMin();
+		if (!timer->Task)
+		{
+			// Cancelled, it only had to leave the heap
+			JobsTimerFree(scheduler, timer);
+			continue;
+		}
+
+		Job job = {};
+		job.scheduler = scheduler;
+		job.handle = timer->Handle;
+		job.task = timer->Task;
+		job.stack = timer->Stack;
+		job.groupJobEnd = 1;
+		job.priority = timer->Priority;
+		dueJobs[dueCount++] = job;
+
+		if (timer->Period)
+		{
+			zpl_atomic32_fetch_add(&timer->Handle->Counter, 1);
+			timer->Due += timer->Period;
+			if (timer->Due <= now)
+				timer->Due = now + timer->Period;
+			heap->PushMin(&timer->Due, timer);
+		}
+		else
+		{
+			JobsTimerFree(scheduler, timer);
+		}
+	}
+	JobsTimerUpdateNext(scheduler);
+	zpl_mutex_unlock(&scheduler->TimerLock);
+
+	// Outside the lock, a job run inline by a full queue may add timers
+	for (u32 dueIdx = 0; dueIdx < dueCount; ++dueIdx)
+	{
+		JobsSubmit(dueJobs[dueIdx]);
+	}
+	JobsWakeWorkers(scheduler, dueCount);
+}
+
+internal JobTimerId
+JobsTimerAdd(JobScheduler* scheduler, JobHandle* handle, u64 due, u64 period, JobWorkFunc task, void* stack, JobPriority priority)
+{
+	SAssert(scheduler);
+	SAssert(handle);
+	SAssert(task);
+	SAssertMsg(scheduler->Timers, "Jobs are not initialized");
+
+	zpl_mutex_lock(&scheduler->TimerLock);
+	JobTimer* timer = scheduler->FreeTimers;
+	if (!timer)
+	{
+		zpl_mutex_unlock(&scheduler->TimerLock);
+		SCAL_ERROR("All %d job timers are in use", JOB_TIMER_COUNT);
+		return 0;
+	}
+	SLStackPop(scheduler->FreeTimers, Next);
+
+	timer->Due = due;
+	timer->Period = period;
+	timer->Handle = handle;
+	timer->Task = task;
+	timer->Stack = stack;
+	timer->Priority = priority;
+
+	// One-shot timers are counted until they run, periodic ones per run
+	if (!period)
+		zpl_atomic32_fetch_add(&handle->Counter, 1);
+
+	scheduler->TimerHeap.PushMin(&timer->Due, timer);
+	bool isEarliest = scheduler->TimerHeap.Items[0].User == timer;
+	JobsTimerUpdateNext(scheduler);
+
+	u32 timerIdx = (u32)(timer - scheduler->Timers);
+	JobTimerId id = ((u32)timer->Generation << 16) | (timerIdx + 1);
+	zpl_mutex_unlock(&scheduler->TimerLock);
+
+	// Parked workers sleep until the previous earliest timer
+	if (isEarliest)
+		JobsWakeWorkers(scheduler, 1);
+
+	return id;
+}
+
+JobTimerId JobsExecuteAt(JobHandle* handle, u64 osTime, JobWorkFunc task, void* stack, JobPriority priority)
+{
+	return JobsExecuteAt(&JobsState, handle, osTime, task, stack, priority);
+}
+
+JobTimerId JobsExecuteAt(JobScheduler* scheduler, JobHandle* handle, u64 osTime, JobWorkFunc task, void* stack, JobPriority priority)
+{
+	return JobsTimerAdd(scheduler, handle, osTime, 0, task, stack, priority);
+}
+
+JobTimerId JobsExecuteEvery(JobHandle* handle, u32 periodMs, JobWorkFunc task, void* stack, JobPriority priority)
+{
+	return JobsExecuteEvery(&JobsState, handle, periodMs, task, stack, priority);
+}
+
+JobTimerId JobsExecuteEvery(JobScheduler* scheduler, JobHandle* handle, u32 periodMs, JobWorkFunc task, void* stack, JobPriority priority)
+{
+	SAssert(periodMs > 0);
+	u64 period = Max((u64)1, (u64)periodMs * Platform::GetOSFreq() / 1000);
+	return JobsTimerAdd(scheduler, handle, Platform::GetOSTime() + period, period, task, stack, priority);
+}
+
+bool JobsTimerCancel(JobTimerId id)
+{
+	return JobsTimerCancel(&JobsState, id);
+}
+
+bool JobsTimerCancel(JobScheduler* scheduler, JobTimerId id)
+{
+	SAssert(scheduler);
+	u32 timerIdx = (id & 0xFFFF) - 1;
+	if (id == 0 || timerIdx >= JOB_TIMER_COUNT || !scheduler->Timers)
+		return false;
+
+	zpl_mutex_lock(&scheduler->TimerLock);
+	JobTimer* timer = &scheduler->Timers[timerIdx];
+	bool isPending = timer->Generation == (u16)(id >> 16) && timer->Task;
+	JobHandle* release = nullptr;
+	if (isPending)
+	{
+		// Left in the heap until it is due, JobsPollTimers frees it then
+		timer->Task = nullptr;
+		if (!timer->Period)
+			release = timer->Handle;
+	}
+	zpl_mutex_unlock(&scheduler->TimerLock);
+
+	if (release)
+		JobHandleRelease(release, 1);
+	return isPending;
+}
+
+void JobsExecute(JobHandle* handle, JobWorkFunc task, void* stack, JobPriority priority)
+{
+	JobsExecute(&JobsState, handle, task, stack, priority);
+}
+
+void JobsExecute(JobScheduler* scheduler, JobHandle* handle, JobWorkFunc task, void* stack, JobPriority priority)
+{
+	SAssert(scheduler);
+	SAssert(handle);
+	SAssert(task);
+
+	// Context state is updated:
+	zpl_atomic32_fetch_add(&handle->Counter, 1);
+
+	Job job = {};
+	job.scheduler = scheduler;
+	job.handle = handle;
+	job.task = task;
+	job.stack = stack;
+	job.groupJobEnd = 1;
+	job.priority = priority;
+	JobsSubmit(job);
+	JobsWakeWorkers(scheduler, 1);
+}
+
+void JobsDispatch(JobHandle* handle, u32 jobCount, u32 groupSize, JobWorkFunc task, void* stack, JobPriority priority)
+{
+	JobsDispatch(&JobsState, handle, jobCount, groupSize, task, stack, priority);
+}
+
+void JobsDispatch(JobScheduler* scheduler, JobHandle* handle, u32 jobCount, u32 groupSize, JobWorkFunc task, void* stack, JobPriority priority)
+{
+	Job job = {};
+	job.scheduler = scheduler;
+	job.handle = handle;
+	job.task = task;
+	job.stack = stack;
+	job.priority = priority;
+	JobsSubmitGroups(job, jobCount, groupSize);
+}
+
+void JobsDispatchAuto(JobHandle* handle, u32 jobCount, JobWorkFunc task, void* stack, JobPriority priority)
+{
+	JobsDispatchAuto(&JobsState, handle, jobCount, task, stack, priority);
+}
+
+void JobsDispatchAuto(JobScheduler* scheduler, JobHandle* handle, u32 jobCount, JobWorkFunc task, void* stack, JobPriority priority)
+{
+	Job job = {};
+	job.scheduler = scheduler;
+	job.handle = handle;
+	job.task = task;
+	job.stack = stack;
+	job.priority = priority;
+	JobsSubmitSplittable(job, jobCount);
+}
+
+void JobsDispatchRange(JobHandle* handle, u32 jobCount, u32 groupSize, JobRangeFunc task, void* stack, JobPriority priority)
+{
+	JobsDispatchRange(&JobsState, handle, jobCount, groupSize, task, stack, priority);
+}
+
+void JobsDispatchRange(JobScheduler* scheduler, JobHandle* handle, u32 jobCount, u32 groupSize, JobRangeFunc task, void* stack, JobPriority priority)
+{
+	Job job = {};
+	job.scheduler = scheduler;
+	job.handle = handle;
+	job.rangeTask = task;
+	job.stack = stack;
+	job.priority = priority;
+	JobsSubmitGroups(job, jobCount, groupSize);
+}
+
+void JobsDispatchRangeAuto(JobHandle* handle, u32 jobCount, JobRangeFunc task, void* stack, JobPriority priority)
+{
+	JobsDispatchRangeAuto(&JobsState, handle, jobCount, task, stack, priority);
+}
+
+void JobsDispatchRangeAuto(JobScheduler* scheduler, JobHandle* handle, u32 jobCount, JobRangeFunc task, void* stack, JobPriority priority)
+{
+	Job job = {};
+	job.scheduler = scheduler;
+	job.handle = handle;
+	job.rangeTask = task;
+	job.stack = stack;
+	job.priority = priority;
+	JobsSubmitSplittable(job, jobCount);
+}
+
+void JobsGetStats(JobStats* stats, JobWorkerStats* perThread, u32 perThreadCount, JobScheduler* scheduler)
+{
+	SAssert(stats);
+	SAssert(scheduler);
+	*stats = {};
+	if (!scheduler->Stats)
+		return;
+
+	u64 cpuNow = Platform::GetCPUTime();
+	u64 cpuElapsed = cpuNow - scheduler->StatsResetCPU;
+	u64 osElapsed = Platform::GetOSTime() - scheduler->StatsResetOS;
+	stats->ElapsedMs = 1000.0 * (double)osElapsed / (double)Platform::GetOSFreq();
+	stats->TicksToMs = (cpuElapsed > 0) ? stats->ElapsedMs / (double)cpuElapsed : 0.0;
+
+	for (u32 threadIdx = 0; threadIdx <= scheduler->NumThreads; ++threadIdx)
+	{
+		const JobStatsSlot* slot = &scheduler->Stats[threadIdx];
+		JobWorkerStats thread;
+		thread.JobsExecuted = slot->Counters.JobsExecuted - slot->Baseline.JobsExecuted;
+		thread.StealAttempts = slot->Counters.StealAttempts - slot->Baseline.StealAttempts;
+		thread.Steals = slot->Counters.Steals - slot->Baseline.Steals;
+		thread.Parks = slot->Counters.Parks - slot->Baseline.Parks;
+		thread.IdleTicks = slot->Counters.IdleTicks - slot->Baseline.IdleTicks;
+		// A park still in progress, since the reset at most
+		u64 idleSince = Max(slot->IdleSince, scheduler->StatsResetCPU);
+		if (slot->IdleSince && cpuNow > idleSince)
+			thread.IdleTicks += cpuNow - idleSince;
+		bool isWorker = threadIdx < scheduler->NumThreads;
+		thread.BusyTicks = (isWorker && cpuElapsed > thread.IdleTicks) ? cpuElapsed - thread.IdleTicks : 0;
+
+		if (threadIdx < perThreadCount)
+			perThread[threadIdx] = thread;
+
+		stats->Total.JobsExecuted += thread.JobsExecuted;
+		stats->Total.StealAttempts += thread.StealAttempts;
+		stats->Total.Steals += thread.Steals;
+		stats->Total.Parks += thread.Parks;
+		stats->Total.IdleTicks += thread.IdleTicks;
+		stats->Total.BusyTicks += thread.BusyTicks;
+	}
+
+	for (u32 queueIdx = 0; queueIdx < scheduler->NumThreads; ++queueIdx)
+	{
+		u32 highWater = (u32)zpl_atomic32_load(&scheduler->JobQueuePerThread[queueIdx].HighWater);
+		stats->QueueHighWater = Max(stats->QueueHighWater, highWater);
+	}
+	stats->Overflows = (u64)zpl_atomic64_load(&scheduler->Overflows);
+	stats->InlineRuns = (u64)zpl_atomic64_load(&scheduler->InlineRuns);
+}
+
+void JobsResetStats(JobScheduler* scheduler)
+{
+	SAssert(scheduler);
+	if (!scheduler->Stats)
+		return;
+
+	for (u32 threadIdx = 0; threadIdx <= scheduler->NumThreads; ++threadIdx)
+	{
+		JobStatsSlot* slot = &scheduler->Stats[threadIdx];
+		slot->Baseline = slot->Counters;
+	}
+	for (u32 queueIdx = 0; queueIdx < scheduler->NumThreads; ++queueIdx)
+	{
+		zpl_atomic32_store(&scheduler->JobQueuePerThread[queueIdx].HighWater, 0);
+	}
+	zpl_atomic64_store(&scheduler->Overflows, 0);
+	zpl_atomic64_store(&scheduler->InlineRuns, 0);
+	scheduler->StatsResetCPU = Platform::GetCPUTime();
+	scheduler->StatsResetOS = Platform::GetOSTime();
+}
+
+// Idle time of every worker so far, counting parks still in progress. Time in the reserve is
+// left out, utilization is measured over the active workers.
+internal u64
+JobsElasticIdleTicks(JobScheduler* scheduler, u64 now)
+{
+	u64 idle = 0;
+	for (u32 threadIdx = 0; threadIdx < scheduler->NumThreads; ++threadIdx)
+	{
+		const JobStatsSlot* slot = &scheduler->Stats[threadIdx];
+		u64 idleSince = slot->IdleSince;
+		bool isInReserve = slot->IsInReserve;
+		u64 reserve = slot->ReserveTicks;
+		u64 total = slot->Counters.IdleTicks;
+		idle += (total > reserve) ? total - reserve : 0;
+		if (idleSince && !isInReserve && now > idleSince)
+			idle += now - idleSince;
+	}
+	return idle;
+}
+
+// Runs as a periodic timer job on the scheduler it resizes
+internal void
+JobsElasticTick(JobArgs* args)
+{
+	JobScheduler* scheduler = (JobScheduler*)args->StackMemory;
+	const JobElasticPolicy& policy = scheduler->Elastic;
+
+	u64 now = Platform::GetCPUTime();
+	u64 idle = JobsElasticIdleTicks(scheduler, now);
+	u64 elapsed = now - scheduler->ElasticLastCPU;
+	u64 idleElapsed = (idle > scheduler->ElasticLastIdle) ? idle - scheduler->ElasticLastIdle : 0;
+	scheduler->ElasticLastCPU = now;
+	scheduler->ElasticLastIdle = idle;
+	if (elapsed == 0)
+		return;
+
+	u32 active = (u32)zpl_atomic32_load(&scheduler->ActiveThreads);
+	double utilization = ClampValue(1.0 - (double)idleElapsed / ((double)elapsed * active), 0.0, 1.0);
+
+	// More workers only help if jobs are waiting for one
+	bool hasQueuedJobs = false;
+	for (u32 queueIdx = 0; queueIdx < scheduler->NumThreads && !hasQueuedJobs; ++queueIdx)
+	{
+		for (int lane = JOB_PRIORITY_HIGH; lane < JOB_PRIORITY_MAX; ++lane)
+			hasQueuedJobs |= !scheduler->JobQueuePerThread[queueIdx].IsEmpty((JobPriority)lane);
+	}
+
+	if (utilization > policy.GrowAbove && hasQueuedJobs)
+	{
+		++scheduler->ElasticHighSamples;
+		scheduler->ElasticLowSamples = 0;
+	}
+	else if (utilization < policy.ShrinkBelow)
+	{
+		++scheduler->ElasticLowSamples;
+		scheduler->ElasticHighSamples = 0;
+	}
+	else
+	{
+		scheduler->ElasticLowSamples = 0;
+		scheduler->ElasticHighSamples = 0;
+	}
+
+	if (scheduler->ElasticHighSamples >= policy.GrowSamples && active < scheduler->NumThreads)
+	{
+		scheduler->ElasticHighSamples = 0;
+		zpl_atomic32_store(&scheduler->ActiveThreads, (i32)active + 1);
+		zpl_atomic32_fetch_add(&scheduler->ReserveEpoch, 1);
+		FutexWakeAll(&scheduler->ReserveEpoch);
+		LogInfo("[ Jobs ] %s: utilization %.2f, %u workers active", scheduler->Name, utilization, active + 1);
+	}
+	else if (scheduler->ElasticLowSamples >= policy.ShrinkSamples && active > policy.MinThreadCount)
+	{
+		// The last active worker moves to the reserve the next time it looks for work
+		scheduler->ElasticLowSamples = 0;
+		zpl_atomic32_store(&scheduler->ActiveThreads, (i32)active - 1);
+		LogInfo("[ Jobs ] %s: utilization %.2f, %u workers active", scheduler->Name, utilization, active - 1);
+	}
+}
+
+void JobsSetElasticPolicy(const JobElasticPolicy* policy, JobScheduler* scheduler)
+{
+	SAssert(scheduler);
+	SAssertMsg(scheduler->NumThreads > 0, "Jobs are not initialized");
+
+	if (scheduler->ElasticTimer)
+	{
+		JobsTimerCancel(scheduler, scheduler->ElasticTimer);
+		scheduler->ElasticTimer = 0;
+		JobHandleWait(&scheduler->ElasticHandle);
+	}
+
+	if (!policy)
+	{
+		zpl_atomic32_store(&scheduler->ActiveThreads, (i32)scheduler->NumThreads);
+		zpl_atomic32_fetch_add(&scheduler->ReserveEpoch, 1);
+		FutexWakeAll(&scheduler->ReserveEpoch);
+		return;
+	}
+
+	JobElasticPolicy* elastic = &scheduler->Elastic;
+	*elastic = *policy;
+	elastic->MinThreadCount = ClampValue(elastic->MinThreadCount, 1u, scheduler->NumThreads);
+	if (!elastic->IntervalMs) elastic->IntervalMs = JOB_ELASTIC_INTERVAL_MS;
+	if (elastic->ShrinkBelow <= 0.0f) elastic->ShrinkBelow = JOB_ELASTIC_SHRINK_BELOW;
+	if (elastic->GrowAbove <= 0.0f) elastic->GrowAbove = JOB_ELASTIC_GROW_ABOVE;
+	if (!elastic->ShrinkSamples) elastic->ShrinkSamples = JOB_ELASTIC_SHRINK_SAMPLES;
+	if (!elastic->GrowSamples) elastic->GrowSamples = JOB_ELASTIC_GROW_SAMPLES;
+	SAssertMsg(elastic->ShrinkBelow < elastic->GrowAbove, "No hysteresis between the shrink and grow thresholds");
+
+	scheduler->ElasticLowSamples = 0;
+	scheduler->ElasticHighSamples = 0;
+	scheduler->ElasticLastCPU = Platform::GetCPUTime();
+	scheduler->ElasticLastIdle = JobsElasticIdleTicks(scheduler, scheduler->ElasticLastCPU);
+	scheduler->ElasticTimer = JobsExecuteEvery(scheduler, &scheduler->ElasticHandle, elastic->IntervalMs, JobsElasticTick, scheduler, JOB_PRIORITY_HIGH);
+}
+
+u32 JobsGetActiveThreadCount(JobScheduler* scheduler)
+{
+	SAssert(scheduler);
+	return (u32)zpl_atomic32_load(&scheduler->ActiveThreads);
+}
+
+void JobsExecuteOnThread(JobHandle* handle, u32 threadIdx, JobWorkFunc task, void* stack)
+{
+	JobsExecuteOnThread(&JobsState, handle, threadIdx, task, stack);
+}
+
+void JobsExecuteOnThread(JobScheduler* scheduler, JobHandle* handle, u32 threadIdx, JobWorkFunc task, void* stack)
+{
+	SAssert(scheduler);
+	SAssert(handle);
+	SAssert(task);
+	SAssert(threadIdx == JOB_THREAD_MAIN || threadIdx < scheduler->NumThreads);
+
+	zpl_atomic32_fetch_add(&handle->Counter, 1);
+
+	Job job = {};
+	job.scheduler = scheduler;
+	job.handle = handle;
+	job.task = task;
+	job.stack = stack;
+	job.groupJobEnd = 1;
+	job.priority = JOB_PRIORITY_HIGH;
+
+	bool isMain = threadIdx == JOB_THREAD_MAIN;
+	JobMailbox* mailbox = &scheduler->Mailboxes[isMain ? scheduler->NumThreads : threadIdx];
+	for (;;)
+	{
+		zpl_mutex_lock(&mailbox->Lock);
+		bool couldPost = mailbox->Jobs.Enqueue(&job);
+		zpl_mutex_unlock(&mailbox->Lock);
+		if (couldPost)
+			break;
+
+		// Full, only the owner can make room
+		if (JobsGetMailbox(scheduler) == mailbox)
+		{
+			JobsRunJob(job);
+			return;
+		}
+
+		// The owner may be waiting on a job still queued, so help instead of just yielding
+		Job other;
+		if (scheduler->NumThreads > 0
+			&& JobsPopNext(scheduler, (u32)zpl_atomic32_fetch_add(&scheduler->NextQueueIndex, 1) % scheduler->NumThreads, &other))
+			JobsRunJob(other);
+		else
+			zpl_yield_thread();
+	}
+
+	if (!isMain)
+	{
+		// The futex cannot pick a thread, wake every parked worker so the owner sees it
+		zpl_mfence();
+		if (zpl_atomic32_load(&scheduler->SleepingCount) > 0)
+		{
+			zpl_atomic32_fetch_add(&scheduler->WakeEpoch, 1);
+			FutexWakeAll(&scheduler->WakeEpoch);
+		}
+		if (threadIdx >= (u32)zpl_atomic32_load(&scheduler->ActiveThreads))
+		{
+			zpl_atomic32_fetch_add(&scheduler->ReserveEpoch, 1);
+			FutexWakeAll(&scheduler->ReserveEpoch);
+		}
+	}
+}
+
+u32 JobsPumpMainThread(JobScheduler* scheduler)
+{
+	SAssert(scheduler);
+	SAssertMsg(JobsGetLocalState() == scheduler->MainThreadState, "Only the thread that called JobsInitialize can pump its mailbox");
+
+	JobMailbox* mailbox = &scheduler->Mailboxes[scheduler->NumThreads];
+	u32 count = 0;
+	Job job;
+	while (mailbox->Jobs.Dequeue(&job))
+	{
+		JobsRunJob(job);
+		++count;
+	}
+	return count;
+}
+
+template<typename Fn>
+struct JobClosureHeap
+{
+	JobClosureHeader Header;
+	Fn Func;
+};
+
+template<typename Fn>
+internal void
+JobsClosureCall(void* closure, JobArgs* args)
+{
+	(*(const Fn*)closure)(args);
+}
+
+template<typename Fn>
+internal void
+JobsClosureCallNoArgs(void* closure, JobArgs*)
+{
+	(*(const Fn*)closure)();
+}
+
+template<typename Fn>
+internal void
+JobsClosureDestroy(JobClosureHeader* header)
+{
+	JobClosureHeap<Fn>* heap = (JobClosureHeap<Fn>*)header;
+	heap->Func.~Fn();
+	SFree(heap);
+}
+
+// Copy fn into the job, refs is how many jobs will run it
+template<typename Fn>
+internal void
+JobsClosureStore(Job* job, const Fn& fn, u32 refs)
+{
+	// Jobs are copied bytewise through the queues, so only trivially copyable closures live inline
+	constexpr bool isInline = sizeof(Fn) <= JOB_CLOSURE_INLINE_SIZE
+		&& alignof(Fn) <= SCAL_DEFAULT_ALIGNMENT
+		&& __is_trivially_copyable(Fn);
+
+	if constexpr (isInline)
+	{
+		CallConstructor(job->closureStorage, Fn)(fn);
+		job->closureHeap = nullptr;
+	}
+	else
+	{
+		static_assert(alignof(Fn) <= SCAL_DEFAULT_ALIGNMENT, "Closure alignment is above SMalloc's");
+		JobClosureHeap<Fn>* heap = (JobClosureHeap<Fn>*)SMalloc(sizeof(JobClosureHeap<Fn>));
+		SAssert(heap);
+		heap->Header.Refs = {};
+		zpl_atomic32_store(&heap->Header.Refs, (i32)refs);
+		heap->Header.Destroy = JobsClosureDestroy<Fn>;
+		CallConstructor(&heap->Func, Fn)(fn);
+
+		void* closure = &heap->Func;
+		SMemCopy(job->closureStorage, &closure, sizeof(closure));
+		job->closureHeap = &heap->Header;
+	}
+}
+
+template<typename Fn>
+void JobsExecuteClosure(JobHandle* handle, const Fn& fn, JobPriority priority)
+{
+	JobsExecuteClosure(&JobsState, handle, fn, priority);
+}
+
+template<typename Fn>
+void JobsExecuteClosure(JobScheduler* scheduler, JobHandle* handle, const Fn& fn, JobPriority priority)
+{
+	SAssert(scheduler);
+	SAssert(handle);
+
+	// Context state is updated:
+	zpl_atomic32_fetch_add(&handle->Counter, 1);
+
+	Job job = {};
+	job.scheduler = scheduler;
+	job.handle = handle;
+	job.closure = JobsClosureCallNoArgs<Fn>;
+	job.groupJobEnd = 1;
+	job.priority = priority;
+	JobsClosureStore(&job, fn, 1);
+	JobsSubmit(job);
+	JobsWakeWorkers(scheduler, 1);
+}
+
+template<typename Fn>
+void JobsDispatchClosure(JobHandle* handle, u32 jobCount, u32 groupSize, const Fn& fn, JobPriority priority)
+{
+	JobsDispatchClosure(&JobsState, handle, jobCount, groupSize, fn, priority);
+}
+
+template<typename Fn>
+void JobsDispatchClosure(JobScheduler* scheduler, JobHandle* handle, u32 jobCount, u32 groupSize, const Fn& fn, JobPriority priority)
+{
+	if (jobCount == 0 || groupSize == 0)
+	{
+		return;
 	}
+
+	Job job = {};
+	job.scheduler = scheduler;
+	job.handle = handle;
+	job.closure = JobsClosureCall<Fn>;
+	job.priority = priority;
+	JobsClosureStore(&job, fn, JobsDispatchGroupCount(jobCount, groupSize));
+	JobsSubmitGroups(job, jobCount, groupSize);
 }
 
 u32 JobsDispatchGroupCount(u32 jobCount, u32 groupSize)
@@ -340,19 +2572,51 @@ u32 JobsDispatchGroupCount(u32 jobCount, u32 groupSize)
 
 void JobHandleWait(const JobHandle* handle)
 {
-	if (JobHandleIsBusy(handle))
+	JOB_TRACE(JOB_TRACE_WAIT_BEGIN, handle, 0, 0);
+
+#if SCAL_JOBS_FIBERS
+	JobsThreadState* local = JobsGetLocalState();
+	if (local->CurrentFiber && local->CurrentFiber != &local->ThreadFiber)
 	{
-		// Wake any threads that might be sleeping:
-		//internal_state.wakeCondition.notify_all();
-		for (u32 threadId = 0 ; threadId < JobsState.NumThreads; ++threadId)
-			zpl_semaphore_post(&JobsState.Threads.At(threadId)->semaphore, 1);
+		while (JobHandleIsBusy(handle))
+		{
+			// Park this job on the handle, the worker goes on with a resumed or a free fiber
+			JobFiber* next = JobsFiberPopReady(local->Scheduler);
+			if (!next)
+				next = JobsFiberAcquire(local->Scheduler);
+			if (!next)
+				break; // out of fibers, wait like a regular thread
+
+			local->CurrentFiber->WaitingOn = handle;
+			JOB_TRACE(JOB_TRACE_SUSPEND, handle, 0, 0);
+			JobsFiberSwitch(next, JOB_FIBER_ACTION_WAIT);
+			local = JobsGetLocalState();
+		}
+	}
+#endif
 
+	JobScheduler* scheduler = JobsGetCurrentScheduler();
+	if (JobHandleIsBusy(handle) && scheduler->NumThreads > 0)
+	{
+		// Workers were woken when the jobs were queued
 		// work() will pick up any jobs that are on stand by and execute them on this thread:
-		zpl_i32 idx = zpl_atomic32_fetch_add(&JobsState.NextQueueIndex, 1) % JobsState.NumThreads;
-		Work(idx);
+		zpl_i32 idx = zpl_atomic32_fetch_add(&scheduler->NextQueueIndex, 1) % scheduler->NumThreads;
+		Work(scheduler, idx);
+	}
 
+	if (JobHandleIsBusy(handle))
+	{
+		JobMailbox* mailbox = JobsGetMailbox(scheduler);
 		while (JobHandleIsBusy(handle))
 		{
+			// The running jobs may post work only this thread can do
+			Job job;
+			if (mailbox && mailbox->Jobs.Dequeue(&job))
+			{
+				JobsRunJob(job);
+				continue;
+			}
+
 			// If we are here, then there are still remaining jobs that work() couldn't pick up.
 			//	In this case those jobs are not standing by on a queue but currently executing
 			//	on other threads, so they cannot be picked up by this thread.
@@ -360,4 +2624,132 @@ void JobHandleWait(const JobHandle* handle)
 			zpl_yield_thread();
 		}
 	}
+
+	JOB_TRACE(JOB_TRACE_WAIT_END, handle, 0, 0);
+}
+
+#if SCAL_JOBS_TRACE
+void JobsTraceStart(JobScheduler* scheduler)
+{
+	SAssert(scheduler);
+	scheduler->TraceStartCPU = Platform::GetCPUTime();
+	scheduler->TraceStartOS = Platform::GetOSTime();
+	scheduler->TraceStopCPU = 0;
+	scheduler->TraceStopOS = 0;
+	zpl_atomic32_store(&scheduler->TraceEnabled, 1);
+}
+
+void JobsTraceStop(JobScheduler* scheduler)
+{
+	SAssert(scheduler);
+	zpl_atomic32_store(&scheduler->TraceEnabled, 0);
+	scheduler->TraceStopCPU = Platform::GetCPUTime();
+	scheduler->TraceStopOS = Platform::GetOSTime();
+}
+
+bool JobsTraceExportChrome(const char* path, JobScheduler* scheduler)
+{
+	SAssert(path);
+	SAssert(scheduler);
+	u64 cpuElapsed = scheduler->TraceStopCPU - scheduler->TraceStartCPU;
+	u64 osElapsed = scheduler->TraceStopOS - scheduler->TraceStartOS;
+	if (!scheduler->TraceBuffers || scheduler->TraceStopCPU <= scheduler->TraceStartCPU || osElapsed == 0)
+	{
+		LogErr("[ Jobs ] No trace to export, record one with JobsTraceStart and JobsTraceStop");
+		return false;
+	}
+
+	FILE* file = fopen(path, "w");
+	if (!file)
+	{
+		LogErr("[ Jobs ] Could not open %s for the trace", path);
+		return false;
+	}
+
+	// Trace-event timestamps are in microseconds
+	double ticksToUs = 1000000.0 * (double)osElapsed / (double)Platform::GetOSFreq() / (double)cpuElapsed;
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	const char* separator = "";
+	for (u32 threadIdx = 0; threadIdx <= scheduler->NumThreads; ++threadIdx)
+	{
+		bool isMain = threadIdx == scheduler->NumThreads;
+		if (isMain)
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"Main\"}}", separator, threadIdx);
+		else
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s_%u\"}}", separator, threadIdx, scheduler->Name, threadIdx);
+		separator = ",\n";
+
+		JobTraceBuffer* buffer = &scheduler->TraceBuffers[threadIdx];
+		u64 count = buffer->Count;
+		u64 first = (count > JOB_TRACE_CAPACITY) ? count - JOB_TRACE_CAPACITY : 0;
+
+		// Slices still open on this thread, ends without a begin were cut off by the ring
+		u32 openCount = 0;
+		double lastTs = 0.0;
+		for (u64 eventIdx = first; eventIdx < count; ++eventIdx)
+		{
+			const JobTraceEvent* event = &buffer->Events[eventIdx & (JOB_TRACE_CAPACITY - 1)];
+			if (event->Time < scheduler->TraceStartCPU || event->Time > scheduler->TraceStopCPU)
+				continue;
+
+			double ts = (double)(event->Time - scheduler->TraceStartCPU) * ticksToUs;
+			lastTs = ts;
+			switch (event->Type)
+			{
+			case JOB_TRACE_POP:
+				fprintf(file, ",\n{\"name\":\"Queue depth\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":0,\"args\":{\"Queue_%u\":%u}}"
+					, ts, event->Queue, event->Depth);
+				if (!isMain && event->Queue != threadIdx)
+				{
+					fprintf(file, ",\n{\"name\":\"Steal\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"from\":%u,\"group\":%u}}"
+						, ts, threadIdx, event->Queue, event->GroupId);
+				}
+				break;
+			case JOB_TRACE_JOB_BEGIN:
+				fprintf(file, ",\n{\"name\":\"Job\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"group\":%u,\"handle\":\"%p\",\"priority\":%u}}"
+					, ts, threadIdx, event->GroupId, event->Handle, event->Priority);
+				++openCount;
+				break;
+			case JOB_TRACE_WAIT_BEGIN:
+				fprintf(file, ",\n{\"name\":\"Wait\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"handle\":\"%p\"}}"
+					, ts, threadIdx, event->Handle);
+				++openCount;
+				break;
+			case JOB_TRACE_PARK_BEGIN:
+				fprintf(file, ",\n{\"name\":\"Parked\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}", ts, threadIdx);
+				++openCount;
+				break;
+			case JOB_TRACE_JOB_END:
+			case JOB_TRACE_WAIT_END:
+			case JOB_TRACE_PARK_END:
+				if (openCount > 0)
+				{
+					fprintf(file, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}", ts, threadIdx);
+					--openCount;
+				}
+				break;
+			case JOB_TRACE_SUSPEND:
+				fprintf(file, ",\n{\"name\":\"Suspend\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"handle\":\"%p\"}}"
+					, ts, threadIdx, event->Handle);
+				// The fiber leaves with its job and wait, the thread goes on with another one
+				for (; openCount > 0; --openCount)
+					fprintf(file, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}", ts, threadIdx);
+				break;
+			}
+		}
+
+		for (; openCount > 0; --openCount)
+			fprintf(file, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}", lastTs, threadIdx);
+	}
+	fprintf(file, "\n]}\n");
+
+	bool written = !ferror(file);
+	fclose(file);
+	if (written)
+		LogInfo("[ Jobs ] Trace written to %s", path);
+	else
+		LogErr("[ Jobs ] Failed writing the trace to %s", path);
+	return written;
 }
+#endif
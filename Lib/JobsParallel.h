@@ -0,0 +1,680 @@
+#pragma once
+
+#include "Core.h"
+#include "Jobs.h"
+#include "DArray.h"
+#include "HashMaps.h"
+
+// Parallel loops and algorithms on top of the job system. Every call dispatches, helps out
+// until the work is done and returns, so they can be used from the main thread or from inside
+// a job. Temporaries come from the calling job's scratch arena (JobsGetScratch), or the heap
+// when they outgrow its reservation, and are released before returning. Element types are
+// copied with assignment, keep them POD.
+
+// Below this many items ParallelFor and friends run on the calling thread
+#define PARALLEL_SERIAL_CUTOFF 2048
+
+// Reduce, scan, partition, sort and the hash map build split the input into fixed blocks,
+// at most PARALLEL_BLOCKS_PER_THREAD per worker and no smaller than PARALLEL_MIN_BLOCK_SIZE
+#define PARALLEL_MIN_BLOCK_SIZE 4096
+#define PARALLEL_BLOCKS_PER_THREAD 4
+
+// Hash map build regions are at least this many buckets, so probes rarely cross into the next
+#define PARALLEL_MIN_REGION_SIZE 256
+
+// Temporaries of one call that may go to the heap
+#define PARALLEL_TEMP_HEAP_COUNT 4
+
+template<typename Fn>
+internal void
+ParallelRangeThunk(JobRangeArgs* args)
+{
+	const Fn* fn = (const Fn*)args->StackMemory;
+	(*fn)(args->GroupId, args->Begin, args->End, args->Scratch);
+}
+
+// Calls fn(u32 groupId, u32 begin, u32 end, Arena* scratch) over [0, count) and waits for it.
+// groupSize 0 lets the scheduler split the range, see JobsDispatchRangeAuto. Runs on the
+// caller's scheduler, so algorithms started from a background pool stay on its cores.
+template<typename Fn>
+inline void
+ParallelForRange(u32 count, u32 groupSize, const Fn& fn)
+{
+	if (count == 0)
+		return;
+
+	bool isSerial = (groupSize == 0) ? count <= PARALLEL_SERIAL_CUTOFF : count <= groupSize;
+	if (isSerial)
+	{
+		ArenaSnapshot snapshot = ArenaSnapshotBegin(JobsGetScratch());
+		fn(0, 0, count, snapshot.Arena);
+		ArenaSnapshotEnd(snapshot);
+		return;
+	}
+
+	JobScheduler* scheduler = JobsGetCurrentScheduler();
+	JobHandle handle = {};
+	if (groupSize == 0)
+		JobsDispatchRangeAuto(scheduler, &handle, count, ParallelRangeThunk<Fn>, (void*)&fn);
+	else
+		JobsDispatchRange(scheduler, &handle, count, groupSize, ParallelRangeThunk<Fn>, (void*)&fn);
+	JobHandleWait(&handle);
+}
+
+// Temporaries that grow with the input. They are pushed on the scratch arena while its
+// reservation has room (JOB_SCRATCH_RESERVE_SIZE for workers), larger ones are heap allocated.
+struct ParallelTemp
+{
+	ArenaSnapshot Snapshot;
+	void* HeapBlocks[PARALLEL_TEMP_HEAP_COUNT];
+	u32 HeapCount;
+};
+
+inline ParallelTemp
+ParallelTempBegin()
+{
+	ParallelTemp temp = {};
+	temp.Snapshot = ArenaSnapshotBegin(JobsGetScratch());
+	return temp;
+}
+
+template<typename T>
+inline T*
+ParallelTempPush(ParallelTemp* temp, u32 count)
+{
+	static_assert(alignof(T) <= SCAL_DEFAULT_ALIGNMENT, "Temporary alignment is above SMalloc's");
+	Arena* arena = temp->Snapshot.Arena;
+	size_t size = sizeof(T) * (size_t)count;
+	// At most half of what is left, the per-block arrays that follow need room too
+	size_t available = arena->ReservedSize - arena->TotalAllocated;
+	if (AlignSize(size, SCAL_CACHE_LINE) <= available / 2)
+		return ArenaPushArray(arena, T, count);
+
+	SAssertMsg(temp->HeapCount < PARALLEL_TEMP_HEAP_COUNT, "Too many heap temporaries, raise PARALLEL_TEMP_HEAP_COUNT");
+	T* memory = (T*)SMalloc(size);
+	SAssert(memory);
+	temp->HeapBlocks[temp->HeapCount++] = memory;
+	return memory;
+}
+
+inline void
+ParallelTempEnd(ParallelTemp* temp)
+{
+	for (u32 blockIdx = 0; blockIdx < temp->HeapCount; ++blockIdx)
+		SFree(temp->HeapBlocks[blockIdx]);
+	temp->HeapCount = 0;
+	ArenaSnapshotEnd(temp->Snapshot);
+}
+
+struct ParallelBlocks
+{
+	u32 Count;
+	u32 Size;
+};
+
+inline ParallelBlocks
+ParallelGetBlocks(u32 count)
+{
+	u32 maxBlocks = Max(1u, JobsGetThreadCount(JobsGetCurrentScheduler()) * PARALLEL_BLOCKS_PER_THREAD);
+
+	ParallelBlocks blocks;
+	blocks.Size = Max((u32)PARALLEL_MIN_BLOCK_SIZE, (count + maxBlocks - 1) / maxBlocks);
+	blocks.Count = Max(1u, JobsDispatchGroupCount(count, blocks.Size));
+	return blocks;
+}
+
+// fn(u32 index)
+template<typename Fn>
+inline void
+ParallelForIndex(u32 count, const Fn& fn)
+{
+	ParallelForRange(count, 0, [&](u32, u32 begin, u32 end, Arena*)
+		{
+			for (u32 i = begin; i < end; ++i)
+				fn(i);
+		});
+}
+
+// fn(T& item)
+template<typename T, typename Fn>
+inline void
+ParallelFor(T* items, u32 count, const Fn& fn)
+{
+	ParallelForRange(count, 0, [&](u32, u32 begin, u32 end, Arena*)
+		{
+			for (u32 i = begin; i < end; ++i)
+				fn(items[i]);
+		});
+}
+
+template<typename T, typename Fn>
+inline void
+ParallelFor(DArray<T>* array, const Fn& fn)
+{
+	SAssert(array);
+	ParallelFor(array->Memory, array->Count, fn);
+}
+
+// out[i] = fn(in[i]), in and out may be the same array
+template<typename TIn, typename TOut, typename Fn>
+inline void
+ParallelTransform(const TIn* in, TOut* out, u32 count, const Fn& fn)
+{
+	ParallelForRange(count, 0, [&](u32, u32 begin, u32 end, Arena*)
+		{
+			for (u32 i = begin; i < end; ++i)
+				out[i] = fn(in[i]);
+		});
+}
+
+template<typename T>
+inline void
+ParallelCopy(T* dst, const T* src, u32 count)
+{
+	ParallelForRange(count, 0, [&](u32, u32 begin, u32 end, Arena*)
+		{
+			SMemCopy(dst + begin, src + begin, (end - begin) * sizeof(T));
+		});
+}
+
+// op(T, T) must be associative. Blocks are combined in order, so the result does not depend
+// on which worker ran what, only on the worker count.
+template<typename T, typename Op>
+inline T
+ParallelReduce(const T* in, u32 count, T identity, const Op& op)
+{
+	if (count == 0)
+		return identity;
+
+	ParallelBlocks blocks = ParallelGetBlocks(count);
+	ArenaSnapshot snapshot = ArenaSnapshotBegin(JobsGetScratch());
+	T* partials = ArenaPushArray(snapshot.Arena, T, blocks.Count);
+
+	ParallelForRange(count, blocks.Size, [&](u32 block, u32 begin, u32 end, Arena*)
+		{
+			T value = identity;
+			for (u32 i = begin; i < end; ++i)
+				value = op(value, in[i]);
+			partials[block] = value;
+		});
+
+	T result = identity;
+	for (u32 block = 0; block < blocks.Count; ++block)
+		result = op(result, partials[block]);
+
+	ArenaSnapshotEnd(snapshot);
+	return result;
+}
+
+// Block sums, a serial scan over the sums, then every block scans again from its carry
+template<typename T, typename Op>
+internal void
+ParallelScan(const T* in, T* out, u32 count, T identity, const Op& op, bool isInclusive)
+{
+	if (count == 0)
+		return;
+
+	ParallelBlocks blocks = ParallelGetBlocks(count);
+	ArenaSnapshot snapshot = ArenaSnapshotBegin(JobsGetScratch());
+	T* carries = ArenaPushArray(snapshot.Arena, T, blocks.Count);
+
+	if (blocks.Count > 1)
+	{
+		ParallelForRange(count, blocks.Size, [&](u32 block, u32 begin, u32 end, Arena*)
+			{
+				T value = identity;
+				for (u32 i = begin; i < end; ++i)
+					value = op(value, in[i]);
+				carries[block] = value;
+			});
+	}
+
+	// The last block's sum is never needed, with a single block none were computed
+	T running = identity;
+	for (u32 block = 0; block < blocks.Count; ++block)
+	{
+		T carry = running;
+		if (block + 1 < blocks.Count)
+			running = op(running, carries[block]);
+		carries[block] = carry;
+	}
+
+	ParallelForRange(count, blocks.Size, [&](u32 block, u32 begin, u32 end, Arena*)
+		{
+			T value = carries[block];
+			for (u32 i = begin; i < end; ++i)
+			{
+				T item = in[i];
+				if (isInclusive)
+				{
+					value = op(value, item);
+					out[i] = value;
+				}
+				else
+				{
+					out[i] = value;
+					value = op(value, item);
+				}
+			}
+		});
+
+	ArenaSnapshotEnd(snapshot);
+}
+
+// out[i] = in[0] op ... op in[i], in and out may be the same array
+template<typename T, typename Op>
+inline void
+ParallelInclusiveScan(const T* in, T* out, u32 count, T identity, const Op& op)
+{
+	ParallelScan(in, out, count, identity, op, true);
+}
+
+// out[i] = identity op in[0] op ... op in[i - 1], in and out may be the same array
+template<typename T, typename Op>
+inline void
+ParallelExclusiveScan(const T* in, T* out, u32 count, T identity, const Op& op)
+{
+	ParallelScan(in, out, count, identity, op, false);
+}
+
+// Stable partition, items where pred(item) is true move to the front. Returns how many.
+template<typename T, typename Pred>
+inline u32
+ParallelPartition(T* items, u32 count, const Pred& pred)
+{
+	if (count == 0)
+		return 0;
+
+	ParallelBlocks blocks = ParallelGetBlocks(count);
+	ParallelTemp scratch = ParallelTempBegin();
+	u32* trueOffsets = ParallelTempPush<u32>(&scratch, blocks.Count);
+	u8* isTrue = ParallelTempPush<u8>(&scratch, count);
+	T* temp = ParallelTempPush<T>(&scratch, count);
+
+	ParallelForRange(count, blocks.Size, [&](u32 block, u32 begin, u32 end, Arena*)
+		{
+			u32 trueCount = 0;
+			for (u32 i = begin; i < end; ++i)
+			{
+				isTrue[i] = pred(items[i]) ? 1 : 0;
+				trueCount += isTrue[i];
+			}
+			trueOffsets[block] = trueCount;
+		});
+
+	u32 totalTrue = 0;
+	for (u32 block = 0; block < blocks.Count; ++block)
+	{
+		u32 blockTrue = trueOffsets[block];
+		trueOffsets[block] = totalTrue;
+		totalTrue += blockTrue;
+	}
+
+	ParallelForRange(count, blocks.Size, [&](u32 block, u32 begin, u32 end, Arena*)
+		{
+			u32 trueIdx = trueOffsets[block];
+			u32 falseIdx = totalTrue + (begin - trueOffsets[block]);
+			for (u32 i = begin; i < end; ++i)
+			{
+				if (isTrue[i])
+					temp[trueIdx++] = items[i];
+				else
+					temp[falseIdx++] = items[i];
+			}
+		});
+
+	ParallelCopy(items, (const T*)temp, count);
+
+	ParallelTempEnd(&scratch);
+	return totalTrue;
+}
+
+// Stable counting scatter of src into dst by bucketOf(item) < bucketCount. Writes the first index
+// of every bucket plus count at the end to bucketStarts when given. Returns false, leaving dst
+// untouched, when every item falls into the same bucket.
+template<typename T, typename BucketFn>
+internal bool
+ParallelScatterByBucket(const T* src, T* dst, u32 count, u32 bucketCount, const BucketFn& bucketOf, u32* bucketStarts)
+{
+	ParallelBlocks blocks = ParallelGetBlocks(count);
+	ArenaSnapshot snapshot = ArenaSnapshotBegin(JobsGetScratch());
+	u32* offsets = ArenaPushArrayZero(snapshot.Arena, u32, blocks.Count * bucketCount);
+
+	// Each block owns one row of counts, later turned into its write offsets
+	ParallelForRange(count, blocks.Size, [&](u32 block, u32 begin, u32 end, Arena*)
+		{
+			u32* blockCounts = offsets + block * bucketCount;
+			for (u32 i = begin; i < end; ++i)
+				++blockCounts[bucketOf(src[i])];
+		});
+
+	// Bucket major then block order keeps equal buckets in their original order
+	bool isSingleBucket = false;
+	u32 running = 0;
+	for (u32 bucket = 0; bucket < bucketCount; ++bucket)
+	{
+		if (bucketStarts)
+			bucketStarts[bucket] = running;
+
+		u32 bucketBegin = running;
+		for (u32 block = 0; block < blocks.Count; ++block)
+		{
+			u32* offset = &offsets[block * bucketCount + bucket];
+			u32 blockCount = *offset;
+			*offset = running;
+			running += blockCount;
+		}
+		if (running - bucketBegin == count)
+			isSingleBucket = true;
+	}
+	if (bucketStarts)
+		bucketStarts[bucketCount] = count;
+
+	if (!isSingleBucket)
+	{
+		ParallelForRange(count, blocks.Size, [&](u32 block, u32 begin, u32 end, Arena*)
+			{
+				u32* blockOffsets = offsets + block * bucketCount;
+				for (u32 i = begin; i < end; ++i)
+					dst[blockOffsets[bucketOf(src[i])]++] = src[i];
+			});
+	}
+
+	ArenaSnapshotEnd(snapshot);
+	return !isSingleBucket;
+}
+
+// Stable LSD radix sort, 8 bits per pass, on keyOf(item) which must return an unsigned integer.
+// Passes where every key has the same digit are skipped. Other keys go through ParallelSort.
+template<typename T, typename KeyFn>
+inline void
+ParallelSortByKey(T* items, u32 count, const KeyFn& keyOf)
+{
+	typedef decltype(keyOf(*items)) Key;
+	static_assert((Key)-1 > (Key)0, "ParallelSortByKey needs an unsigned integer key");
+
+	if (count < 2)
+		return;
+
+	ParallelTemp scratch = ParallelTempBegin();
+	T* temp = ParallelTempPush<T>(&scratch, count);
+
+	T* src = items;
+	T* dst = temp;
+	for (u32 shift = 0; shift < sizeof(Key) * 8; shift += 8)
+	{
+		auto digitOf = [&](const T& item) { return (u32)((u64)keyOf(item) >> shift) & 0xFF; };
+		if (ParallelScatterByBucket((const T*)src, dst, count, 256, digitOf, nullptr))
+			Swap(src, dst);
+	}
+
+	if (src != items)
+		ParallelCopy(items, (const T*)src, count);
+
+	ParallelTempEnd(&scratch);
+}
+
+template<typename T, typename KeyFn>
+inline void
+ParallelSortByKey(DArray<T>* array, const KeyFn& keyOf)
+{
+	SAssert(array);
+	ParallelSortByKey(array->Memory, array->Count, keyOf);
+}
+
+// Blocks of ParallelSort start as insertion sorted runs of this many items
+#define PARALLEL_SORT_RUN_SIZE 32
+
+// Stable merge of a and b into out, ties are taken from a
+template<typename T, typename Less>
+internal void
+ParallelMerge(const T* a, u32 aCount, const T* b, u32 bCount, T* out, const Less& less)
+{
+	u32 aIdx = 0;
+	u32 bIdx = 0;
+	while (aIdx < aCount && bIdx < bCount)
+		*out++ = less(b[bIdx], a[aIdx]) ? b[bIdx++] : a[aIdx++];
+	while (aIdx < aCount)
+		*out++ = a[aIdx++];
+	while (bIdx < bCount)
+		*out++ = b[bIdx++];
+}
+
+// How many of the first outputIdx items of ParallelMerge(a, b) come from a
+template<typename T, typename Less>
+internal u32
+ParallelMergeSplit(const T* a, u32 aCount, const T* b, u32 bCount, u32 outputIdx, const Less& less)
+{
+	u32 low = (outputIdx > bCount) ? outputIdx - bCount : 0;
+	u32 high = Min(outputIdx, aCount);
+	while (low < high)
+	{
+		u32 mid = low + (high - low) / 2;
+		if (!less(b[outputIdx - mid - 1], a[mid]))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+// Stable merge sort with less(const T&, const T&) as a strict weak ordering, for keys
+// ParallelSortByKey cannot take. Blocks are sorted serially, then every merge pass splits its
+// output into blocks so the last merges keep all workers busy.
+template<typename T, typename Less>
+inline void
+ParallelSort(T* items, u32 count, const Less& less)
+{
+	if (count < 2)
+		return;
+
+	ParallelTemp scratch = ParallelTempBegin();
+	T* temp = ParallelTempPush<T>(&scratch, count);
+	ParallelBlocks blocks = ParallelGetBlocks(count);
+
+	ParallelForRange(count, blocks.Size, [&](u32, u32 begin, u32 end, Arena*)
+		{
+			u32 blockCount = end - begin;
+			T* src = items + begin;
+			T* dst = temp + begin;
+			for (u32 run = 0; run < blockCount; run += PARALLEL_SORT_RUN_SIZE)
+			{
+				u32 runEnd = Min(run + PARALLEL_SORT_RUN_SIZE, blockCount);
+				for (u32 i = run + 1; i < runEnd; ++i)
+				{
+					T item = src[i];
+					u32 j = i;
+					for (; j > run && less(item, src[j - 1]); --j)
+						src[j] = src[j - 1];
+					src[j] = item;
+				}
+			}
+
+			for (u32 width = PARALLEL_SORT_RUN_SIZE; width < blockCount; width *= 2)
+			{
+				for (u32 low = 0; low < blockCount; low += width * 2)
+				{
+					u32 mid = Min(low + width, blockCount);
+					u32 high = Min(low + width * 2, blockCount);
+					ParallelMerge((const T*)src + low, mid - low, (const T*)src + mid, high - mid, dst + low, less);
+				}
+				Swap(src, dst);
+			}
+
+			if (src != items + begin)
+				SMemCopy(items + begin, src, blockCount * sizeof(T));
+		});
+
+	// Widths stay multiples of the block size, so no output block straddles two merges
+	T* src = items;
+	T* dst = temp;
+	for (u32 width = blocks.Size; width < count; width *= 2)
+	{
+		ParallelForRange(count, blocks.Size, [&](u32, u32 begin, u32 end, Arena*)
+			{
+				u32 low = begin - begin % (width * 2);
+				u32 mid = Min(low + width, count);
+				u32 high = Min(low + width * 2, count);
+				const T* a = src + low;
+				const T* b = src + mid;
+				u32 aCount = mid - low;
+				u32 bCount = high - mid;
+
+				u32 aBegin = ParallelMergeSplit(a, aCount, b, bCount, begin - low, less);
+				u32 aEnd = ParallelMergeSplit(a, aCount, b, bCount, end - low, less);
+				u32 bBegin = begin - low - aBegin;
+				u32 bEnd = end - low - aEnd;
+				ParallelMerge(a + aBegin, aEnd - aBegin, b + bBegin, bEnd - bBegin, dst + begin, less);
+			});
+		Swap(src, dst);
+	}
+
+	if (src != items)
+		ParallelCopy(items, (const T*)src, count);
+
+	ParallelTempEnd(&scratch);
+}
+
+template<typename T, typename Less>
+inline void
+ParallelSort(DArray<T>* array, const Less& less)
+{
+	SAssert(array);
+	ParallelSort(array->Memory, array->Count, less);
+}
+
+// Fill an initialized, empty map with count key/value pairs. The buckets are split into regions,
+// pairs are grouped by the region of their home bucket and every region is filled by one job.
+// A pair pushed past the end of its region is added serially afterwards. Keys should be unique,
+// for duplicates one of the values is kept. Returns false when the pairs do not fit.
+template<typename K, typename V>
+inline bool
+ParallelHashMapBuild(StaticHashMap<K, V>* map, const K* keys, const V* values, u32 count)
+{
+	SAssert(map);
+	SAssert(map->Buckets);
+	SAssert(map->Count == 0);
+	SAssert(keys);
+	SAssert(values);
+
+	if (count == 0)
+		return true;
+
+	if (map->Count + count > map->MaxCount)
+	{
+		SCAL_ERROR("HashMap is full!");
+		return false;
+	}
+
+	u32 capacity = map->Capacity;
+	u32 regionCount = 1;
+	while (regionCount * 2 <= capacity / PARALLEL_MIN_REGION_SIZE
+		&& regionCount < JobsGetThreadCount(JobsGetCurrentScheduler()) * PARALLEL_BLOCKS_PER_THREAD)
+	{
+		regionCount *= 2;
+	}
+	u32 regionSize = capacity / regionCount;
+
+	struct Entry
+	{
+		u32 Home;
+		u32 Item;
+	};
+
+	struct Overflow
+	{
+		K Key;
+		V Value;
+	};
+
+	ParallelTemp scratch = ParallelTempBegin();
+	u32* regionStarts = ArenaPushArray(scratch.Snapshot.Arena, u32, regionCount + 1);
+	u32* placedCounts = ArenaPushArrayZero(scratch.Snapshot.Arena, u32, regionCount);
+	u32* overflowCounts = ArenaPushArrayZero(scratch.Snapshot.Arena, u32, regionCount);
+	Entry* entries = ParallelTempPush<Entry>(&scratch, count);
+	Entry* sorted = ParallelTempPush<Entry>(&scratch, count);
+	Overflow* overflows = ParallelTempPush<Overflow>(&scratch, count);
+
+	ParallelForRange(count, 0, [&](u32, u32 begin, u32 end, Arena*)
+		{
+			for (u32 i = begin; i < end; ++i)
+			{
+				entries[i].Home = (u32)HashAndMod(&keys[i], capacity);
+				entries[i].Item = i;
+			}
+		});
+
+	auto regionOf = [&](const Entry& entry) { return entry.Home / regionSize; };
+	if (!ParallelScatterByBucket((const Entry*)entries, sorted, count, regionCount, regionOf, regionStarts))
+		sorted = entries;
+
+	// Same robin hood insert as StaticHashMap::Add, but it stops at the region's end
+	ParallelForRange(regionCount, 1, [&](u32 region, u32, u32, Arena*)
+		{
+			u32 regionEnd = (region + 1) * regionSize;
+			u32 placed = 0;
+			u32 overflowCount = 0;
+			for (u32 entryIdx = regionStarts[region]; entryIdx < regionStarts[region + 1]; ++entryIdx)
+			{
+				const Entry& entry = sorted[entryIdx];
+
+				StaticHashMapBucket<K, V> swapBucket;
+				swapBucket.Key = keys[entry.Item];
+				swapBucket.ProbeLength = 0;
+				swapBucket.IsUsed = true;
+				swapBucket.Value = values[entry.Item];
+
+				u16 probeLength = 0;
+				u32 idx = entry.Home;
+				while (true)
+				{
+					if (idx == regionEnd)
+					{
+						Overflow* overflow = &overflows[regionStarts[region] + overflowCount++];
+						overflow->Key = swapBucket.Key;
+						overflow->Value = swapBucket.Value;
+						break;
+					}
+
+					StaticHashMapBucket<K, V>* bucket = &map->Buckets[idx];
+					if (!bucket->IsUsed)
+					{
+						*bucket = swapBucket;
+						bucket->ProbeLength = probeLength;
+						++placed;
+						break;
+					}
+
+					if (bucket->Key == swapBucket.Key)
+						break;
+
+					if (probeLength > bucket->ProbeLength)
+					{
+						swapBucket.ProbeLength = probeLength;
+						probeLength = bucket->ProbeLength;
+						StaticHashMapBucket<K, V> tmp = *bucket;
+						*bucket = swapBucket;
+						swapBucket = tmp;
+					}
+
+					++probeLength;
+					++idx;
+				}
+			}
+			placedCounts[region] = placed;
+			overflowCounts[region] = overflowCount;
+		});
+
+	for (u32 region = 0; region < regionCount; ++region)
+		map->Count += placedCounts[region];
+
+	for (u32 region = 0; region < regionCount; ++region)
+	{
+		Overflow* regionOverflows = overflows + regionStarts[region];
+		for (u32 i = 0; i < overflowCounts[region]; ++i)
+			map->Add(&regionOverflows[i].Key, &regionOverflows[i].Value);
+	}
+
+	ParallelTempEnd(&scratch);
+	return true;
+}
@@ -0,0 +1,109 @@
+#pragma warning(disable: 4324) // warning for alignment padding
+
+#pragma once
+
+#include "Base.h"
+
+// Bounded multi producer - multi consumer fifo queue (Dmitry Vyukov's design).
+// Every slot carries a sequence number telling whether it is ready for the producer
+// or the consumer of the current lap, so producers and consumers only contend on
+// their own index and never wait on each other. Capacity must be a power of two.
+// Zeroed memory is an empty queue.
+template<typename T, int Capacity>
+struct QueueMPMC
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "QueueMPMC Capacity must be a power of two");
+
+	struct Cell
+	{
+		// Minus the slot index, so zero is the first lap. Plus the index it is the position
+		// of the next write when free, or that position + 1 when ready to read.
+		zpl_atomic32 Sequence;
+		T Value;
+	};
+
+	alignas(SCAL_CACHE_LINE) zpl_atomic32 First; // Read
+	alignas(SCAL_CACHE_LINE) zpl_atomic32 Last; // Write
+	alignas(SCAL_CACHE_LINE) Cell Memory[Capacity];
+
+	// False when the queue is full
+	bool Enqueue(const T* value)
+	{
+		u32 position = (u32)zpl_atomic32_load(&Last);
+		for (;;)
+		{
+			u32 index = position & (Capacity - 1);
+			Cell* cell = &Memory[index];
+			u32 sequence = (u32)zpl_atomic32_load(&cell->Sequence) + index;
+			i32 diff = (i32)(sequence - position);
+			if (diff == 0)
+			{
+				u32 original = (u32)zpl_atomic32_compare_exchange(&Last, (i32)position, (i32)(position + 1));
+				if (original == position)
+				{
+					zpl_lfence();
+					cell->Value = *value;
+					zpl_sfence();
+					zpl_atomic32_store(&cell->Sequence, (i32)(position + 1 - index));
+					return true;
+				}
+				position = original;
+			}
+			else if (diff < 0)
+			{
+				// The consumer of the previous lap has not taken this slot yet
+				return false;
+			}
+			else
+			{
+				position = (u32)zpl_atomic32_load(&Last);
+			}
+		}
+	}
+
+	bool Dequeue(T* outValue)
+	{
+		u32 position = (u32)zpl_atomic32_load(&First);
+		for (;;)
+		{
+			u32 index = position & (Capacity - 1);
+			Cell* cell = &Memory[index];
+			u32 sequence = (u32)zpl_atomic32_load(&cell->Sequence) + index;
+			i32 diff = (i32)(sequence - (position + 1));
+			if (diff == 0)
+			{
+				u32 original = (u32)zpl_atomic32_compare_exchange(&First, (i32)position, (i32)(position + 1));
+				if (original == position)
+				{
+					zpl_lfence();
+					*outValue = cell->Value;
+					zpl_sfence();
+					zpl_atomic32_store(&cell->Sequence, (i32)(position + Capacity - index));
+					return true;
+				}
+				position = original;
+			}
+			else if (diff < 0)
+			{
+				// Empty, or the producer of this slot has not finished writing it
+				return false;
+			}
+			else
+			{
+				position = (u32)zpl_atomic32_load(&First);
+			}
+		}
+	}
+
+	bool IsEmpty()
+	{
+		return zpl_atomic32_load(&First) == zpl_atomic32_load(&Last);
+	}
+
+	// Approximate while other threads push or pop
+	int Count()
+	{
+		i32 count = (i32)((u32)zpl_atomic32_load(&Last) - (u32)zpl_atomic32_load(&First));
+		return ClampValue(count, 0, Capacity);
+	}
+};
@@ -0,0 +1,158 @@
+#pragma warning(disable: 4324) // warning for alignment padding
+
+#pragma once
+
+#include "Base.h"
+
+// Single producer - single consumer fifo queue. Each side keeps a copy of the other
+// side's index and only reloads it when the copy says the queue is full or empty,
+// so in steady state neither side touches the other's cache line. The batch and
+// Reserve/Commit, Peek/Release calls move many items with one index publish.
+// Capacity must be a power of two. Zeroed memory is an empty queue.
+template<typename T, int Capacity>
+struct QueueSPSC
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "QueueSPSC Capacity must be a power of two");
+
+	// Producer side
+	alignas(SCAL_CACHE_LINE) zpl_atomic32 Last; // Write
+	u32 CachedFirst;
+	// Consumer side
+	alignas(SCAL_CACHE_LINE) zpl_atomic32 First; // Read
+	u32 CachedLast;
+	alignas(SCAL_CACHE_LINE) T Memory[Capacity];
+
+	// False when the queue is full
+	bool Enqueue(const T* value)
+	{
+		return EnqueueMany(value, 1) == 1;
+	}
+
+	// Pushes as many of the values as fit, returns how many
+	u32 EnqueueMany(const T* values, u32 count)
+	{
+		u32 last = (u32)zpl_atomic32_load(&Last);
+		u32 freeCount = FreeCount(last, count);
+		count = Min(count, freeCount);
+		if (count == 0)
+			return 0;
+
+		u32 index = last & (Capacity - 1);
+		u32 firstPart = Min(count, (u32)Capacity - index);
+		for (u32 i = 0; i < firstPart; ++i)
+			Memory[index + i] = values[i];
+		for (u32 i = firstPart; i < count; ++i)
+			Memory[i - firstPart] = values[i];
+
+		zpl_sfence();
+		zpl_atomic32_store(&Last, (i32)(last + count));
+		return count;
+	}
+
+	// Up to count contiguous free slots to construct items in place, fewer where the
+	// ring wraps. Null when full. Nothing is visible to the consumer before Commit.
+	T* Reserve(u32 count, u32* outReserved)
+	{
+		SAssert(outReserved);
+		u32 last = (u32)zpl_atomic32_load(&Last);
+		u32 index = last & (Capacity - 1);
+		count = Min(count, (u32)Capacity - index);
+		u32 freeCount = FreeCount(last, count);
+		*outReserved = Min(count, freeCount);
+		return (*outReserved) ? &Memory[index] : nullptr;
+	}
+
+	// Publish count items written through Reserve
+	void Commit(u32 count)
+	{
+		u32 last = (u32)zpl_atomic32_load(&Last);
+		SAssertMsg(last + count - CachedFirst <= (u32)Capacity, "Committed more than was reserved");
+		zpl_sfence();
+		zpl_atomic32_store(&Last, (i32)(last + count));
+	}
+
+	bool Dequeue(T* outValue)
+	{
+		return DequeueMany(outValue, 1) == 1;
+	}
+
+	// Pops up to maxCount items, returns how many
+	u32 DequeueMany(T* outValues, u32 maxCount)
+	{
+		u32 first = (u32)zpl_atomic32_load(&First);
+		u32 readyCount = ReadyCount(first, maxCount);
+		u32 count = Min(maxCount, readyCount);
+		if (count == 0)
+			return 0;
+
+		u32 index = first & (Capacity - 1);
+		u32 firstPart = Min(count, (u32)Capacity - index);
+		for (u32 i = 0; i < firstPart; ++i)
+			outValues[i] = Memory[index + i];
+		for (u32 i = firstPart; i < count; ++i)
+			outValues[i] = Memory[i - firstPart];
+
+		zpl_sfence();
+		zpl_atomic32_store(&First, (i32)(first + count));
+		return count;
+	}
+
+	// Up to maxCount contiguous items to read in place, fewer where the ring wraps.
+	// Null when empty. They stay owned by the queue until Release.
+	T* Peek(u32 maxCount, u32* outCount)
+	{
+		SAssert(outCount);
+		u32 first = (u32)zpl_atomic32_load(&First);
+		u32 index = first & (Capacity - 1);
+		maxCount = Min(maxCount, (u32)Capacity - index);
+		u32 readyCount = ReadyCount(first, maxCount);
+		*outCount = Min(maxCount, readyCount);
+		return (*outCount) ? &Memory[index] : nullptr;
+	}
+
+	// Hand count items read through Peek back to the producer
+	void Release(u32 count)
+	{
+		u32 first = (u32)zpl_atomic32_load(&First);
+		SAssertMsg(CachedLast - first >= count, "Released more than was peeked");
+		zpl_sfence();
+		zpl_atomic32_store(&First, (i32)(first + count));
+	}
+
+	bool IsEmpty()
+	{
+		return zpl_atomic32_load(&First) == zpl_atomic32_load(&Last);
+	}
+
+	// Approximate while the other side works
+	int Count()
+	{
+		return (int)((u32)zpl_atomic32_load(&Last) - (u32)zpl_atomic32_load(&First));
+	}
+
+	// Producer only, reloads First if the cached copy leaves less than wanted
+	_FORCE_INLINE_ u32 FreeCount(u32 last, u32 wanted)
+	{
+		u32 freeCount = (u32)Capacity - (last - CachedFirst);
+		if (freeCount < wanted)
+		{
+			CachedFirst = (u32)zpl_atomic32_load(&First);
+			zpl_lfence();
+			freeCount = (u32)Capacity - (last - CachedFirst);
+		}
+		return freeCount;
+	}
+
+	// Consumer only, reloads Last if the cached copy has less than wanted
+	_FORCE_INLINE_ u32 ReadyCount(u32 first, u32 wanted)
+	{
+		u32 readyCount = CachedLast - first;
+		if (readyCount < wanted)
+		{
+			CachedLast = (u32)zpl_atomic32_load(&Last);
+			zpl_lfence();
+			readyCount = CachedLast - first;
+		}
+		return readyCount;
+	}
+};
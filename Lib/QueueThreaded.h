@@ -3,13 +3,19 @@
 #pragma once
 
 #include "Base.h"
+#include "Futex.h"
 
-// Single producer - multi consumer fifo queue
+// Polls DequeueWait makes before parking
+#define QUEUE_THREADED_SPIN_COUNT 64
+
+// Single producer - multi consumer fifo queue. Consumers either poll Dequeue or block in
+// DequeueWait, which parks on a futex on Last once the queue stays empty.
 template<typename T, int Capacity>
 struct QueueThreaded
 {
-	alignas(CACHE_LINE) zpl_atomic32 First; // Read
-	alignas(CACHE_LINE) zpl_atomic32 Last; // Write
+	alignas(SCAL_CACHE_LINE) zpl_atomic32 First; // Read
+	zpl_atomic32 Waiters; // consumers parked in DequeueWait
+	alignas(SCAL_CACHE_LINE) zpl_atomic32 Last; // Write
 	T Memory[Capacity];
 
 	/*
@@ -19,21 +25,38 @@ struct QueueThreaded
 	* 
 	*/
 
+	// False when the queue is full
 	bool Enqueue(const T* value)
 	{
 		int originalLast = zpl_atomic32_load(&Last);
 		int newLast = (originalLast + 1) % Capacity;
-		SAssertMsg(newLast != First.value, "Queue overflow");
 		if (newLast != zpl_atomic32_load(&First))
 		{
 			Memory[originalLast] = *value;
 			zpl_sfence();
 			zpl_atomic32_store(&Last, newLast);
+
+			// Wake a parked consumer if this item made the queue non-empty, the futex
+			// wait already failed for anyone who saw Last change
+			zpl_mfence();
+			if (zpl_atomic32_load(&Waiters) > 0 && zpl_atomic32_load(&First) == originalLast)
+				FutexWake(&Last, 1);
 			return true;
 		}
 		return false;
 	}
 
+	bool IsEmpty()
+	{
+		return zpl_atomic32_load(&First) == zpl_atomic32_load(&Last);
+	}
+
+	// Approximate while other threads push or pop
+	int Count()
+	{
+		return (zpl_atomic32_load(&Last) - zpl_atomic32_load(&First) + Capacity) % Capacity;
+	}
+
 	bool Dequeue(T* outValue)
 	{
 		int originalFirst = zpl_atomic32_load(&First);
@@ -49,4 +72,43 @@ struct QueueThreaded
 		}
 		return false;
 	}
+
+	// Blocks until an item arrives. With timeoutMs >= 0 gives up after that long and
+	// returns false. Spins for a moment before parking.
+	bool DequeueWait(T* outValue, i32 timeoutMs = -1)
+	{
+		for (int spin = 0; spin < QUEUE_THREADED_SPIN_COUNT; ++spin)
+		{
+			if (Dequeue(outValue))
+				return true;
+			zpl_yield();
+		}
+
+		u64 deadline = (timeoutMs >= 0) ? FutexNowMs() + (u64)timeoutMs : 0;
+		for (;;)
+		{
+			if (Dequeue(outValue))
+			{
+				// Producers only wake one consumer per empty to non-empty change, pass it on
+				if (zpl_atomic32_load(&Waiters) > 0 && !IsEmpty())
+					FutexWake(&Last, 1);
+				return true;
+			}
+
+			i32 waitMs = -1;
+			if (timeoutMs >= 0)
+			{
+				u64 now = FutexNowMs();
+				if (now >= deadline)
+					return false;
+				waitMs = (i32)(deadline - now);
+			}
+
+			int last = zpl_atomic32_load(&Last);
+			zpl_atomic32_fetch_add(&Waiters, 1);
+			if (zpl_atomic32_load(&First) == last)
+				FutexWait(&Last, last, waitMs);
+			zpl_atomic32_fetch_add(&Waiters, -1);
+		}
+	}
 };
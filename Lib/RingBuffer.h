@@ -0,0 +1,258 @@
+#pragma warning(disable: 4324) // warning for alignment padding
+
+#pragma once
+
+#include "Core.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#pragma comment(lib, "onecore.lib")
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+// Single producer - single consumer byte ring whose pages are mapped twice back to back,
+// so Memory[Capacity + i] is Memory[i]. Any span up to Capacity bytes starting anywhere
+// in the ring is contiguous, messages are written and read in place without being split
+// at the wrap point. Linux maps a memfd twice, Windows a pagefile section into two
+// placeholder halves.
+struct RingBuffer
+{
+	u8* Memory;				// 2 * Capacity bytes of address space over Capacity bytes of memory
+	u32 Capacity;			// power of two, multiple of the page or allocation granularity
+#ifdef _WIN32
+	HANDLE Mapping;
+#else
+	int Fd;
+#endif
+	// Producer side
+	alignas(SCAL_CACHE_LINE) zpl_atomic32 Last; // Write
+	u32 CachedFirst;
+	// Consumer side
+	alignas(SCAL_CACHE_LINE) zpl_atomic32 First; // Read
+	u32 CachedLast;
+};
+
+// Capacity is minCapacity rounded up to a power of two and the mapping granularity, at most 1GB
+inline bool RingBufferCreate(RingBuffer* ring, u32 minCapacity);
+inline void RingBufferDestroy(RingBuffer* ring);
+
+// Producer. A contiguous span of size bytes to write in place, null if that much is not free.
+// Nothing is visible to the consumer before RingBufferCommit.
+inline u8* RingBufferReserve(RingBuffer* ring, u32 size);
+inline void RingBufferCommit(RingBuffer* ring, u32 size);
+
+// Producer. All or nothing, false if size bytes are not free
+inline bool RingBufferWrite(RingBuffer* ring, const void* data, u32 size);
+
+// Consumer. The readable bytes as one contiguous span, null when empty. Only reloads the
+// producer's index once the bytes seen last time are released.
+inline u8* RingBufferPeek(RingBuffer* ring, u32* outSize);
+
+// Consumer. Hands size bytes read through RingBufferPeek back to the producer
+inline void RingBufferRelease(RingBuffer* ring, u32 size);
+
+// Length prefixed messages on top of the byte stream. The consumer peeks one message at a
+// time and releases it with RingBufferReleaseMessage.
+inline bool RingBufferWriteMessage(RingBuffer* ring, const void* data, u32 size);
+inline u8* RingBufferPeekMessage(RingBuffer* ring, u32* outSize);
+inline void RingBufferReleaseMessage(RingBuffer* ring, u32 size);
+
+// ************************************************************************************
+
+bool RingBufferCreate(RingBuffer* ring, u32 minCapacity)
+{
+	SAssert(ring);
+	SAssertMsg(minCapacity > 0 && minCapacity <= (1u << 30), "RingBuffer capacity must be between 1 byte and 1GB");
+	SMemZero(ring, sizeof(RingBuffer));
+
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	u32 granularity = (u32)info.dwAllocationGranularity;
+#else
+	u32 granularity = (u32)sysconf(_SC_PAGESIZE);
+#endif
+	u32 capacity = granularity;
+	while (capacity < minCapacity)
+		capacity <<= 1;
+	SAssertMsg((capacity & (capacity - 1)) == 0, "Page size is not a power of two");
+
+#ifdef _WIN32
+	HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, capacity, nullptr);
+	if (!mapping)
+	{
+		LogErr("[ RingBuffer ] CreateFileMapping failed, error %u", (u32)GetLastError());
+		return false;
+	}
+
+	// Reserve both halves as one placeholder, split it, and replace each half with a view
+	u8* memory = (u8*)VirtualAlloc2(nullptr, nullptr, 2 * (size_t)capacity, MEM_RESERVE | MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS, nullptr, 0);
+	if (!memory)
+	{
+		LogErr("[ RingBuffer ] VirtualAlloc2 failed, error %u", (u32)GetLastError());
+		CloseHandle(mapping);
+		return false;
+	}
+	VirtualFree(memory, capacity, MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER);
+
+	void* view0 = MapViewOfFile3(mapping, nullptr, memory, 0, capacity, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0);
+	void* view1 = MapViewOfFile3(mapping, nullptr, memory + capacity, 0, capacity, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0);
+	if (!view0 || !view1)
+	{
+		LogErr("[ RingBuffer ] MapViewOfFile3 failed, error %u", (u32)GetLastError());
+		if (view0)
+			UnmapViewOfFile(view0);
+		else
+			VirtualFree(memory, 0, MEM_RELEASE);
+		if (view1)
+			UnmapViewOfFile(view1);
+		else
+			VirtualFree(memory + capacity, 0, MEM_RELEASE);
+		CloseHandle(mapping);
+		return false;
+	}
+	ring->Mapping = mapping;
+#else
+	int fd = memfd_create("RingBuffer", MFD_CLOEXEC);
+	if (fd == -1 || ftruncate(fd, capacity) != 0)
+	{
+		LogErr("[ RingBuffer ] memfd of %u bytes failed, errno %d", capacity, errno);
+		if (fd != -1)
+			close(fd);
+		return false;
+	}
+
+	// Reserve both halves first so nothing else can land between the two maps
+	u8* memory = (u8*)mmap(nullptr, 2 * (size_t)capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED
+		|| mmap(memory, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+		|| mmap(memory + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+	{
+		LogErr("[ RingBuffer ] mmap of %u bytes failed, errno %d", capacity, errno);
+		if (memory != MAP_FAILED)
+			munmap(memory, 2 * (size_t)capacity);
+		close(fd);
+		return false;
+	}
+	ring->Fd = fd;
+#endif
+
+	ring->Memory = memory;
+	ring->Capacity = capacity;
+	return true;
+}
+
+void RingBufferDestroy(RingBuffer* ring)
+{
+	SAssert(ring);
+	if (!ring->Memory)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(ring->Memory);
+	UnmapViewOfFile(ring->Memory + ring->Capacity);
+	CloseHandle(ring->Mapping);
+#else
+	munmap(ring->Memory, 2 * (size_t)ring->Capacity);
+	close(ring->Fd);
+#endif
+	SMemZero(ring, sizeof(RingBuffer));
+}
+
+u8* RingBufferReserve(RingBuffer* ring, u32 size)
+{
+	SAssert(ring);
+	SAssert(ring->Memory);
+	u32 last = (u32)zpl_atomic32_load(&ring->Last);
+	if (ring->Capacity - (last - ring->CachedFirst) < size)
+	{
+		ring->CachedFirst = (u32)zpl_atomic32_load(&ring->First);
+		zpl_lfence();
+		if (ring->Capacity - (last - ring->CachedFirst) < size)
+			return nullptr;
+	}
+	return ring->Memory + (last & (ring->Capacity - 1));
+}
+
+void RingBufferCommit(RingBuffer* ring, u32 size)
+{
+	SAssert(ring);
+	u32 last = (u32)zpl_atomic32_load(&ring->Last);
+	SAssertMsg(last + size - ring->CachedFirst <= ring->Capacity, "Committed more than was reserved");
+	zpl_sfence();
+	zpl_atomic32_store(&ring->Last, (i32)(last + size));
+}
+
+bool RingBufferWrite(RingBuffer* ring, const void* data, u32 size)
+{
+	u8* span = RingBufferReserve(ring, size);
+	if (!span)
+		return false;
+
+	SMemCopy(span, data, size);
+	RingBufferCommit(ring, size);
+	return true;
+}
+
+u8* RingBufferPeek(RingBuffer* ring, u32* outSize)
+{
+	SAssert(ring);
+	SAssert(ring->Memory);
+	SAssert(outSize);
+	u32 first = (u32)zpl_atomic32_load(&ring->First);
+	if (ring->CachedLast == first)
+	{
+		ring->CachedLast = (u32)zpl_atomic32_load(&ring->Last);
+		zpl_lfence();
+	}
+
+	*outSize = ring->CachedLast - first;
+	return (*outSize) ? ring->Memory + (first & (ring->Capacity - 1)) : nullptr;
+}
+
+void RingBufferRelease(RingBuffer* ring, u32 size)
+{
+	SAssert(ring);
+	u32 first = (u32)zpl_atomic32_load(&ring->First);
+	SAssertMsg(ring->CachedLast - first >= size, "Released more than was peeked");
+	zpl_sfence();
+	zpl_atomic32_store(&ring->First, (i32)(first + size));
+}
+
+bool RingBufferWriteMessage(RingBuffer* ring, const void* data, u32 size)
+{
+	u8* span = RingBufferReserve(ring, sizeof(u32) + size);
+	if (!span)
+		return false;
+
+	SMemCopy(span, &size, sizeof(u32));
+	SMemCopy(span + sizeof(u32), data, size);
+	RingBufferCommit(ring, sizeof(u32) + size);
+	return true;
+}
+
+u8* RingBufferPeekMessage(RingBuffer* ring, u32* outSize)
+{
+	SAssert(outSize);
+	u32 available;
+	u8* span = RingBufferPeek(ring, &available);
+	if (!span)
+	{
+		*outSize = 0;
+		return nullptr;
+	}
+
+	// Messages are committed whole, so the rest follows its length
+	SAssert(available >= sizeof(u32));
+	SMemCopy(outSize, span, sizeof(u32));
+	SAssert(available >= sizeof(u32) + *outSize);
+	return span + sizeof(u32);
+}
+
+void RingBufferReleaseMessage(RingBuffer* ring, u32 size)
+{
+	RingBufferRelease(ring, sizeof(u32) + size);
+}
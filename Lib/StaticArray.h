@@ -30,13 +30,11 @@ struct StaticArray
 template<typename T, size_t Capacity>
 struct StaticList
 {
-	constexpr static size_t Capacity = Capacity;
-
 	size_t Count;
 	T Data[Capacity];
 
-	constexpr _FORCE_INLINE_ T* At(size_t idx) { return SAssert(idx < Capacity); return Data + idx; }
-	constexpr _FORCE_INLINE_ T AtCopy(size_t idx) { return SAssert(idx < Capacity); return Data[idx]; }
+	constexpr _FORCE_INLINE_ T* At(size_t idx) { SAssert(idx < Capacity); return Data + idx; }
+	constexpr _FORCE_INLINE_ T AtCopy(size_t idx) { SAssert(idx < Capacity); return Data[idx]; }
 	constexpr _FORCE_INLINE_ size_t MemorySize() { return Capacity * sizeof(T); }
 	constexpr _FORCE_INLINE_ T* Last() { return Data + ((Count > 0) ? Count - 1 : 0); }
 	constexpr _FORCE_INLINE_ void Clear() { Count = 0; }